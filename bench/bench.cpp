@@ -0,0 +1,85 @@
+#include "bench.hpp"
+
+using namespace Bench;
+
+Runner::Runner(const std::string& _filter, size_t _num_samples, double _min_sample_ns) :
+   filter(_filter), num_samples(std::max<size_t>(1, _num_samples)), min_sample_ns(_min_sample_ns) {}
+
+void Runner::run(const std::string& name, const std::function<void()>& body) {
+   if (!filter.empty() && name.find(filter) == std::string::npos) return;
+   using clock = std::chrono::steady_clock;
+   auto time_batch = [&body](size_t batch) {
+      auto start = clock::now();
+      for (size_t i=0; i<batch; ++i) body();
+      return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+   };
+
+   // warm up caches and lazily built tables, then double the batch until a sample is long enough
+   size_t batch = 1;
+   double elapsed = time_batch(batch);
+   while (elapsed < min_sample_ns && batch < (size_t(1) << 30)) {
+      batch *= 2;
+      elapsed = time_batch(batch);
+   }
+
+   std::vector<double> per_call;
+   for (size_t sample=0; sample<num_samples; ++sample) per_call.push_back(time_batch(batch) / batch);
+   std::sort(per_call.begin(), per_call.end());
+   size_t middle = per_call.size() / 2;
+   double median = per_call.size() % 2 ? per_call[middle] : (per_call[middle - 1] + per_call[middle]) / 2;
+   results.push_back({name, batch, per_call.size(), median, per_call.front(), per_call.back()});
+
+   std::cout << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(1)
+             << std::setw(14) << median << " ns/op" << std::setw(10) << batch << " x " << per_call.size() << std::endl;
+}
+
+const std::vector<result>& Runner::get_results() const {
+   return results;
+}
+
+// One benchmark per line, read back by read_medians
+std::string Bench::to_json(const std::vector<result>& results) {
+   std::ostringstream json;
+   json << std::fixed << std::setprecision(2) << "{\n  \"benchmarks\": [\n";
+   for (size_t i=0; i<results.size(); ++i) {
+      const result& r = results[i];
+      json << "    {\"name\": \"" << r.name << "\", \"batch\": " << r.batch << ", \"samples\": " << r.samples
+           << ", \"median_ns\": " << r.median_ns << ", \"min_ns\": " << r.min_ns << ", \"max_ns\": " << r.max_ns << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+   }
+   json << "  ]\n}\n";
+   return json.str();
+}
+
+// name -> median ns/op of a file written by to_json, empty if it can't be read
+std::map<std::string, double> Bench::read_medians(const std::string& path) {
+   static const std::regex entry_regex(".*\"name\":\\s*\"([^\"]+)\".*\"median_ns\":\\s*([0-9.eE+-]+).*");
+   std::map<std::string, double> medians;
+   std::ifstream file(path);
+   std::string line;
+   std::smatch matches;
+   while (std::getline(file, line)) {
+      if (std::regex_match(line, matches, entry_regex)) medians[matches[1].str()] = std::stod(matches[2].str());
+   }
+   return medians;
+}
+
+// Prints the change of every benchmark found in both runs, returns the number slower than the baseline by more than threshold
+int Bench::compare(const std::map<std::string, double>& baseline, const std::vector<result>& results, double threshold, std::ostream& out) {
+   int regressions = 0;
+   out << "\n" << std::left << std::setw(44) << "benchmark" << std::right << std::setw(14) << "baseline" << std::setw(14) << "current" << std::setw(10) << "change" << "\n";
+   for (const result& r : results) {
+      auto base = baseline.find(r.name);
+      if (base == baseline.end() || base->second <= 0) {
+         out << std::left << std::setw(44) << r.name << std::right << std::setw(14) << "-" << std::setw(14) << std::fixed << std::setprecision(1) << r.median_ns << std::setw(10) << "new" << "\n";
+         continue;
+      }
+      double change = r.median_ns / base->second - 1;
+      bool regressed = change > threshold;
+      if (regressed) ++regressions;
+      out << std::left << std::setw(44) << r.name << std::right << std::fixed << std::setprecision(1) << std::setw(14) << base->second
+          << std::setw(14) << r.median_ns << std::setw(9) << std::showpos << change * 100 << std::noshowpos << "%" << (regressed ? "  REGRESSION" : "") << "\n";
+   }
+   out << regressions << " regression(s) above " << std::fixed << std::setprecision(0) << threshold * 100 << "%" << std::endl;
+   return regressions;
+}
@@ -0,0 +1,51 @@
+#ifndef CACHETUNA_BENCH_HPP
+#define CACHETUNA_BENCH_HPP
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip> // setprecision
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Bench {
+   struct result {
+      std::string name;
+      size_t batch;      // calls per sample
+      size_t samples;
+      double median_ns;  // per call
+      double min_ns;
+      double max_ns;
+   };
+
+   // Keeps the compiler from dropping a computation whose value is otherwise unused
+   template <typename T> inline void keep(const T& value) { asm volatile("" : : "r"(&value) : "memory"); }
+
+   /* Runs each benchmark as samples of a batch of calls, the batch sized so a sample lasts about
+    * min_sample_ns; the median per call over the samples is what gets compared between builds.
+   */
+   class Runner {
+      private:
+         std::string filter;
+         size_t num_samples;
+         double min_sample_ns;
+         std::vector<result> results;
+
+      public:
+         Runner(const std::string& _filter, size_t _num_samples, double _min_sample_ns);
+         void run(const std::string& name, const std::function<void()>& body);
+         const std::vector<result>& get_results() const;
+   };
+
+   std::string to_json(const std::vector<result>& results);
+   std::map<std::string, double> read_medians(const std::string& path);
+   int compare(const std::map<std::string, double>& baseline, const std::vector<result>& results, double threshold, std::ostream& out);
+}
+
+#endif //cachetuna_bench_hpp
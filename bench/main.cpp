@@ -0,0 +1,283 @@
+// std
+#include <cstdlib>
+#include <random>
+
+// ftxui
+#include "ftxui/dom/elements.hpp"
+#include "ftxui/screen/screen.hpp"
+
+// cachetuna
+#include "bench.hpp"
+#include "braille_generator.hpp"
+#include "graph.hpp"
+#include "misc.hpp"
+#include "series_index.hpp"
+#include "way_mask.hpp"
+
+// autotuna
+#include "autotuna.hpp"
+
+/* Simulated backend: everything the benchmarks read from libpqos, ps or /etc/sysconfig is synthesised
+ * from a fixed seed, so runs are comparable between builds and need no CAT hardware or root.
+*/
+
+// Decreasing miss curve per cos, convex unless noisy (which sends the optimizer down its DP path)
+static std::map<unsigned, std::vector<uint64_t>> simulate_miss_curves(int num_cos, int num_ways, bool noisy) {
+   std::mt19937_64 random(num_cos * 1000 + num_ways);
+   std::uniform_real_distribution<double> scale(1e5, 1e7), decay(0.2, 1.5), noise(0.8, 1.2);
+   std::map<unsigned, std::vector<uint64_t>> curves;
+   for (int cos=1; cos<=num_cos; ++cos) {
+      double base = scale(random), rate = decay(random);
+      for (int ways=1; ways<=num_ways; ++ways) {
+         double misses = base * std::exp(-rate * ways) + base * 0.01;
+         curves[cos].push_back(static_cast<uint64_t>(noisy ? misses * noise(random) : misses));
+      }
+   }
+   return curves;
+}
+
+static std::map<unsigned, int> simulate_priorities(int num_cos) {
+   std::map<unsigned, int> priority_map;
+   for (int cos=1; cos<=num_cos; ++cos) priority_map[cos] = cos % 4 == 0 ? 0 : num_cos - cos + 1;
+   return priority_map;
+}
+
+// Monitoring samples of one cos: a daily-ish pattern with bursts
+static std::vector<uint64_t> simulate_samples(size_t count) {
+   std::mt19937_64 random(42);
+   std::uniform_int_distribution<uint64_t> jitter(0, 50000), burst(0, 99);
+   std::vector<uint64_t> samples;
+   samples.reserve(count);
+   for (size_t i=0; i<count; ++i) {
+      uint64_t value = static_cast<uint64_t>(500000 + 400000 * std::sin(i / 3000.0)) + jitter(random);
+      samples.push_back(burst(random) == 0 ? value * 8 : value);
+   }
+   return samples;
+}
+
+static std::string simulate_cache_policy(int num_cos, int num_ways, int num_cores) {
+   std::ostringstream policy;
+   policy << "# Cache allocation policy\n# generated for the benchmark\n";
+   int cores_per_cos = std::max(1, num_cores / num_cos);
+   for (int cos=1; cos<=num_cos; ++cos) {
+      Way_Mask mask = Way_Mask::range(num_ways, (cos - 1) % num_ways, 1 + cos % 3);
+      policy << "POLICY_" << cos << "=" << mask.to_binary() << " ;  NAME_" << cos << "=\"Service " << cos << "\" ;  CORES_" << cos
+             << "=\"" << (cos - 1) * cores_per_cos << "-" << cos * cores_per_cos - 1 << "\"\n";
+   }
+   return policy.str();
+}
+
+static std::string simulate_conf(int num_keys) {
+   std::ostringstream conf;
+   conf << "# cachetuna.conf\n";
+   for (int i=0; i<num_keys; ++i) conf << "AUTOTUNA_MAX_WAYS_" << i << "=" << 1 + i % 11 << "   # bound\n\n";
+   return conf.str();
+}
+
+// ps ao user,pid,pcpu,pmem,psr,stat,start,time,command
+static std::vector<std::string> simulate_ps(size_t num_processes, int num_cores) {
+   std::vector<std::string> lines = {"USER         PID %CPU %MEM PSR STAT START   TIME COMMAND\n"};
+   for (size_t pid=1; pid<=num_processes; ++pid) {
+      std::ostringstream line;
+      line << (pid % 5 ? "root" : "qube") << "    " << std::setw(8) << pid << "  0.3  0.1 " << std::setw(3) << pid % num_cores
+           << " Ssl  Oct18   0:04 /usr/bin/service --worker " << pid << "\n";
+      lines.push_back(line.str());
+   }
+   return lines;
+}
+
+static void bench_autotuna(Bench::Runner& runner) {
+   struct size { int num_cos; int num_ways; bool noisy; };
+   Autotuna::Optimizer optimizer;
+   for (const size& s : std::vector<size>{{4, 11, false}, {4, 11, true}, {15, 20, true}, {16, 64, false}, {16, 64, true}}) {
+      std::map<unsigned, std::vector<uint64_t>> curves = simulate_miss_curves(s.num_cos, s.num_ways, s.noisy);
+      std::map<unsigned, int> priority_map = simulate_priorities(s.num_cos);
+      Autotuna::scaled_data data = Autotuna::scale_misses_matrix(curves, priority_map);
+      Autotuna::ways_limits limits = Autotuna::get_ways_limits(data, {}, s.num_ways - s.num_cos);
+      std::string name = "autotuna/optimal_ways/" + std::to_string(s.num_cos) + "cos_" + std::to_string(s.num_ways) + "ways" + (s.noisy ? "_nonconvex" : "");
+      runner.run(name, [&] {
+         std::vector<Autotuna::tuning_plan> plans = Autotuna::calculate_optimal_ways_combination(optimizer, data, limits, priority_map, 0, 3);
+         Bench::keep(plans);
+      });
+   }
+
+   for (int num_ways : {11, 64}) {
+      runner.run("autotuna/construct_way_mask/" + std::to_string(num_ways) + "ways", [&] {
+         Way_Mask all(0, num_ways);
+         for (int ways=1; ways<num_ways; ++ways) all |= Autotuna::construct_way_mask({0, 1}, num_ways, ways, num_ways - ways);
+         std::string binary = all.to_binary();
+         Bench::keep(binary);
+      });
+   }
+}
+
+// Sliding one day history as the monitoring thread keeps it, and the plot decimation reading it
+static void bench_history(Bench::Runner& runner) {
+   const size_t capacity = 86400;
+   std::vector<uint64_t> samples = simulate_samples(capacity * 2);
+   std::vector<uint64_t> values(samples.begin(), samples.begin() + capacity);
+   Series_Index index(capacity);
+   for (const uint64_t& value : values) index.push(value);
+
+   size_t next = capacity;
+   runner.run("history/append", [&] {
+      values.erase(values.begin());
+      index.pop_front();
+      values.push_back(samples[next]);
+      index.push(samples[next]);
+      next = next + 1 < samples.size() ? next + 1 : capacity;
+   });
+
+   for (size_t span : {size_t(60), size_t(3600), capacity}) {
+      runner.run("history/read_" + std::to_string(span) + "s_200cols", [&] {
+         size_t first = values.size() - span, columns = std::min<size_t>(200, span);
+         uint64_t total = 0;
+         for (size_t column=0; column<columns; ++column) {
+            total += index.span(values, first + column * span / columns, first + (column + 1) * span / columns).max;
+         }
+         Bench::keep(total);
+      });
+   }
+}
+
+static void bench_graph(Bench::Runner& runner) {
+   using namespace ftxui;
+   auto screen = Screen::Create(Dimension::Fixed(200), Dimension::Fixed(50));
+
+   Graph bar_graph("LLC Occupancy", "llc");
+   std::vector<uint64_t> bars = simulate_samples(16);
+   runner.run("graph/bar_16cos_200x50", [&] {
+      Render(screen, bar_graph.get_graph(bars));
+      Bench::keep(screen);
+   });
+
+   Graph line_graph("Cache Misses", "misses");
+   std::vector<uint64_t> samples = simulate_samples(86400);
+   Series_Index index;
+   for (const uint64_t& value : samples) index.push(value);
+   Render(screen, line_graph.get_graph(std::vector<plot_series>{}, line_graph.get_view({}))); // sizes the canvas
+   for (size_t num_cos : {size_t(4), size_t(16)}) {
+      runner.run("graph/line_" + std::to_string(num_cos) + "cos_200x50", [&] {
+         plot_view view = line_graph.get_view({3600, 0});
+         std::vector<plot_series> series_vec;
+         size_t first = samples.size() - view.span;
+         for (size_t cos=0; cos<num_cos; ++cos) {
+            plot_series series = {static_cast<unsigned>(cos), {}, {}, {}};
+            for (size_t column=0; column<view.columns; ++column) {
+               series.columns.push_back(index.span(samples, first + column * view.span / view.columns, first + (column + 1) * view.span / view.columns));
+               series.forecast.push_back(Series_Index::no_value);
+            }
+            series_vec.push_back(std::move(series));
+         }
+         Render(screen, line_graph.get_graph(series_vec, view));
+         Bench::keep(screen);
+      });
+   }
+}
+
+static void bench_braille(Bench::Runner& runner) {
+   std::string image = Misc::get_executable_path() + "img/Tuna/0.png";
+   if (std::filesystem::exists(image)) {
+      runner.run("braille/generate_120x40", [&] {
+         std::vector<std::string> frame = Braille_Generator::generate_braille(120, 40, image.c_str());
+         Bench::keep(frame);
+      });
+   }
+
+   // same pipeline on a synthetic gradient, independent of the image files
+   const int width = 240, height = 160;
+   std::vector<uint8_t> gray(width * height);
+   for (int i=0; i<height; ++i) {
+      for (int j=0; j<width; ++j) gray[i * width + j] = static_cast<uint8_t>((i * 255 / height + j * 255 / width) / 2);
+   }
+   runner.run("braille/dither_encode_240x160", [&] {
+      std::vector<std::string> frame = Braille_Generator::encode(Braille_Generator::dither(gray.data(), width, height), width, height);
+      Bench::keep(frame);
+   });
+}
+
+static void bench_parsing(Bench::Runner& runner) {
+   std::string conf_path = (std::filesystem::temp_directory_path() / "cachetuna_bench.conf").string();
+   std::ofstream(conf_path) << simulate_conf(64);
+   runner.run("config/read_key_values_64", [&] {
+      std::map<std::string, std::string> settings = Misc::read_key_values(conf_path);
+      Bench::keep(settings);
+   });
+   std::filesystem::remove(conf_path);
+
+   std::string policy = simulate_cache_policy(16, 20, 224);
+   runner.run("config/parse_cache_policy_16cos", [&] {
+      std::istringstream file(policy);
+      std::map<int, std::string> tags = Misc::parse_cache_policy_tags(file);
+      Bench::keep(tags);
+   });
+
+   const int num_cores = 224;
+   std::vector<std::string> ps = simulate_ps(5000, num_cores);
+   std::map<int, unsigned> core_cos;
+   for (int core=0; core<num_cores; ++core) core_cos[core] = core % 16;
+   runner.run("processes/scan_5000", [&] {
+      std::vector<std::vector<std::string>> processes(16);
+      for (const std::string& line : ps) {
+         auto cos = core_cos.find(Misc::get_ps_processor(line));
+         if (cos != core_cos.end()) processes[cos->second].push_back(line);
+      }
+      Bench::keep(processes);
+   });
+}
+
+static void usage() {
+   std::cout << "usage: cachetuna_bench [--filter <substring>] [--samples <n>] [--min-sample-ms <ms>]\n"
+                "                       [--output <results.json>] [--compare <baseline.json>] [--threshold <fraction>]\n";
+}
+
+int main(int argc, char **argv) {
+   std::string filter, output, baseline;
+   size_t num_samples = 15;
+   double min_sample_ms = 5, threshold = 0.1;
+   for (int i=1; i<argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h" || i + 1 >= argc) {
+         usage();
+         return arg == "--help" || arg == "-h" ? 0 : 2;
+      }
+      std::string value = argv[++i];
+      if (arg == "--filter") filter = value;
+      else if (arg == "--samples") num_samples = std::strtoul(value.c_str(), nullptr, 10);
+      else if (arg == "--min-sample-ms") min_sample_ms = std::strtod(value.c_str(), nullptr);
+      else if (arg == "--output") output = value;
+      else if (arg == "--compare") baseline = value;
+      else if (arg == "--threshold") threshold = std::strtod(value.c_str(), nullptr);
+      else {
+         usage();
+         return 2;
+      }
+   }
+
+   std::map<std::string, double> baseline_medians;
+   if (!baseline.empty()) {
+      baseline_medians = Bench::read_medians(baseline);
+      if (baseline_medians.empty()) {
+         std::cerr << "No results in " << baseline << std::endl;
+         return 2;
+      }
+   }
+
+   Bench::Runner runner(filter, num_samples, min_sample_ms * 1e6);
+   bench_autotuna(runner);
+   bench_history(runner);
+   bench_graph(runner);
+   bench_braille(runner);
+   bench_parsing(runner);
+
+   if (!output.empty()) {
+      std::ofstream file(output);
+      file << Bench::to_json(runner.get_results());
+      if (!file) {
+         std::cerr << "Could not write " << output << std::endl;
+         return 2;
+      }
+   }
+   if (!baseline.empty() && Bench::compare(baseline_medians, runner.get_results(), threshold, std::cout) > 0) return 1;
+   return 0;
+}
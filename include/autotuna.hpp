@@ -9,16 +9,45 @@
 #include <limits>
 #include <algorithm>
 
+// cachetuna
+#include "way_mask.hpp"
+
+// autotuna
+#include "optimizer.hpp"
+
 namespace Autotuna {
    struct scaled_data {
       std::vector<unsigned> order;
       std::vector<std::vector<float>> matrix;
+      std::vector<float> weights; // priority weight each row was scaled by
+   };
+
+   struct ways_limits {
+      std::map<unsigned, int> min_ways;
+      std::map<unsigned, int> max_ways;
+   };
+
+   // Two cos sharing ways: head's ways end num_shared ways into tail's ways
+   struct way_overlap {
+      unsigned head;
+      unsigned tail;
+      int num_shared;
+   };
+
+   struct tuning_plan {
+      std::map<unsigned, int> ways_map; // cos -> num ways, shared ways count towards both cos
+      std::vector<way_overlap> overlaps;
+      double cost; // predicted priority weighted misses
    };
 
-   std::string construct_bitmask_str(std::pair<int, int> way_contention_index, int l3_num_ways, int num_active_ways, int pos_0);
+   Way_Mask construct_way_mask(std::pair<int, int> way_contention_index, int l3_num_ways, int num_active_ways, int pos_0);
+   Way_Mask construct_way_mask(std::pair<int, int> way_contention_index, int l3_num_ways, int num_active_ways, int pos_0, int member_offset, int member_ways);
+   std::map<unsigned, Way_Mask> move_one_way(const std::map<unsigned, Way_Mask>& bitmasks, std::pair<int, int> way_contention_index, unsigned donor, unsigned receiver);
+   float normalise_priority_ranking(int rank, const std::map<unsigned, int>& priority_map);
    scaled_data scale_misses_matrix(const std::map<unsigned, std::vector<uint64_t>>& cos_misses_matrix, std::map<unsigned, int>& priority_map);
-   void adjust_misses_matrix_values(scaled_data& data, const std::map<unsigned, int>& min_ways_map, int root_cos, int remaining_ways);
-   void calculate_optimal_ways_combination(const scaled_data& data, std::map<unsigned, int>& min_ways_map, const std::map<unsigned, int>& priority_map, int root_cos);
+   ways_limits get_ways_limits(const scaled_data& data, const std::map<unsigned, int>& min_ways_map, int remaining_ways);
+   int distribute_leftover_ways(std::vector<int>& ways, const std::vector<int>& max_ways, int leftover);
+   std::vector<tuning_plan> calculate_optimal_ways_combination(Optimizer& optimizer, const scaled_data& data, const ways_limits& limits, const std::map<unsigned, int>& priority_map, int root_cos, int num_solutions);
 }
 
 #endif //cachetuna_autotuna_hpp
@@ -0,0 +1,29 @@
+#ifndef CACHETUNA_AUTOTUNA_CACHE_HPP
+#define CACHETUNA_AUTOTUNA_CACHE_HPP
+
+// std
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// autotuna
+#include "autotuna_state.hpp"
+
+namespace Autotuna {
+   struct cached_curve {
+      int64_t timestamp;
+      std::vector<uint64_t> misses; // misses average for 1..n ways
+   };
+
+   std::string workload_fingerprint(const std::vector<std::string>& processes, size_t num_cores);
+   std::map<std::string, cached_curve> load_curve_cache(const std::string& file_path);
+   void store_curve(const std::string& file_path, const std::string& fingerprint, const std::vector<uint64_t>& misses);
+   bool curve_matches(const std::vector<uint64_t>& misses, int num_ways, uint64_t live_misses, uint64_t threshold, double tolerance);
+}
+
+#endif //cachetuna_autotuna_cache_hpp
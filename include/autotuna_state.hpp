@@ -0,0 +1,28 @@
+#ifndef CACHETUNA_AUTOTUNA_STATE_HPP
+#define CACHETUNA_AUTOTUNA_STATE_HPP
+
+// std
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace Autotuna {
+   struct measurement {
+      int64_t timestamp; // seconds since epoch
+      uint64_t misses;
+      uint64_t objective; // equals misses unless the cos has a multi-metric objective
+   };
+
+   // cos -> num_ways -> measured misses average
+   typedef std::map<unsigned, std::map<int, measurement>> analysis_state;
+
+   int64_t now_seconds();
+   analysis_state load_analysis_state(const std::string& file_path, const std::string& signature, int64_t max_age);
+   void save_analysis_state(const std::string& file_path, const std::string& signature, const analysis_state& state);
+   void append_analysis_state(const std::string& file_path, unsigned cos, int num_ways, uint64_t misses, uint64_t objective);
+}
+
+#endif //cachetuna_autotuna_state_hpp
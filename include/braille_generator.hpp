@@ -3,17 +3,47 @@
 
 // std
 #include <algorithm>
-#include <bitset>
-#include <codecvt>
-#include <iostream>
-#include <locale>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Braille_Generator {
+   typedef std::vector<std::vector<std::string>> frames;
+
+   const std::array<std::string, 256>& braille_table();
+   std::vector<uint8_t> dither(const uint8_t* gray, int width, int height);
+   std::vector<std::string> encode(const std::vector<uint8_t>& dots, int width, int height);
    std::vector<std::string> generate_braille(int width_w, int height_w, const char *filename);
-   std::vector<std::vector<std::string>> generate_all_frames(int width, int height, const std::string& directory, int frame_count);
+   frames generate_all_frames(int width, int height, const std::string& directory, int frame_count);
+
+   /* Animation frames per terminal size, generated in the background on first use
+    * and cached on disk (directory/cache/<width>x<height>.frames) for the next launches.
+   */
+   class Frame_Cache {
+      private:
+         std::string directory;
+         int frame_count;
+         std::mutex mutex;
+         std::map<std::pair<int, int>, std::shared_future<frames>> sizes;
+         std::string get_cache_path(int width, int height);
+         int64_t get_source_time();
+         bool load(int width, int height, frames& loaded);
+         void save(int width, int height, const frames& generated);
+
+      public:
+         Frame_Cache(const std::string& _directory, int _frame_count);
+         void prepare(int width, int height);
+         std::vector<std::string> get_frame(int width, int height, int index);
+   };
 }
 
 #endif // CACHETUNA_BRAILLE_GENERATOR_HPP
@@ -0,0 +1,42 @@
+#ifndef CACHETUNA_CONTROLLER_HPP
+#define CACHETUNA_CONTROLLER_HPP
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace Autotuna {
+   struct cos_observation {
+      unsigned cos;
+      int num_ways;        // current allocation
+      int floor_ways;      // never shrink below
+      double misses;       // average over the latest window
+      double occupancy;    // average llc over the latest window / allocated size
+      float weight;        // priority weight
+      int64_t last_change; // seconds since epoch, 0 if never changed
+      double sustained_occupancy; // average llc over the reclaim window / allocated size, -1 if the history is shorter
+      double sensitivity;  // extra misses expected from losing one way
+      double forecast_misses;    // highest forecast over the lead time, -1 without a forecast
+      double forecast_occupancy;
+   };
+
+   struct way_move {
+      bool valid;
+      unsigned donor;
+      unsigned receiver;
+   };
+
+   // donor -> receiver -> number of ways lent
+   typedef std::map<unsigned, std::map<unsigned, int>> way_loans;
+
+   bool needs_more_ways(const cos_observation& observation, uint64_t threshold);
+   cos_observation anticipate(const cos_observation& observation);
+   way_move decide_way_move(const std::vector<cos_observation>& observations, int64_t now, int64_t min_dwell, double hysteresis, uint64_t threshold);
+   bool is_idle(const cos_observation& observation, double max_occupancy, double max_sensitivity);
+   way_move decide_reclaim(const std::vector<cos_observation>& observations, int64_t now, int64_t min_dwell, double max_occupancy, double max_sensitivity, uint64_t threshold);
+   way_move decide_loan_return(const std::vector<cos_observation>& observations, const way_loans& loans, double return_occupancy);
+}
+
+#endif //cachetuna_controller_hpp
@@ -0,0 +1,36 @@
+#ifndef CACHETUNA_CPU_SET_HPP
+#define CACHETUNA_CPU_SET_HPP
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// cachetuna
+#include "topology.hpp"
+
+/* Set of cpus as a bitset, one bit per cpu
+ * Membership is O(1) and a 224 thread host fits in four words, the named constructors select the cpus
+ * sharing a core, NUMA node or L3 with a cpu for bulk core assignment.
+*/
+class Cpu_Set {
+   private:
+      std::vector<uint64_t> words;
+
+   public:
+      Cpu_Set() = default;
+      Cpu_Set(const std::set<int>& cpus);
+      static Cpu_Set range(int first, int last);
+      static Cpu_Set smt_siblings(const Topology::cpu_topology& topology, int cpu);
+      static Cpu_Set numa_node(const Topology::cpu_topology& topology, int cpu);
+      static Cpu_Set l3_domain(const Topology::cpu_topology& topology, int cpu);
+      void insert(int cpu);
+      void erase(int cpu);
+      bool contains(int cpu) const;
+      size_t count() const;
+      bool empty() const;
+      std::vector<int> to_vector() const;
+};
+
+#endif //cachetuna_cpu_set_hpp
@@ -0,0 +1,80 @@
+#ifndef CACHETUNA_EXPERIMENT_HPP
+#define CACHETUNA_EXPERIMENT_HPP
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Autotuna {
+   // Welford's running mean and variance
+   struct running_stats {
+      size_t count = 0;
+      double mean = 0.0;
+      double m2 = 0.0;
+      void add(double value);
+      double variance() const;
+   };
+
+   struct effect_estimate {
+      size_t n_a, n_b;
+      double mean_a, mean_b;
+      double difference; // b - a
+      double ci_low, ci_high;
+      double relative;   // difference / mean_a
+      double cohens_d;
+      bool significant;  // the confidence interval excludes 0
+   };
+
+   struct experiment_row {
+      unsigned cos;
+      std::string metric;
+      effect_estimate effect;
+   };
+
+   double t_quantile(double p, double df);
+   effect_estimate welch_effect(const running_stats& a, const running_stats& b, double confidence);
+
+   /* Randomised A/B experiment over two allocations
+    * Time is cut into intervals of random length, played as pairs holding both arms in random
+    * order, so drift in the workload hits both arms alike. The first settle samples of each
+    * interval are dropped and every interval contributes its mean as one observation, which keeps
+    * the per second autocorrelation out of the confidence intervals (Welch's t).
+   */
+   class Experiment {
+      private:
+         int duration, min_interval, max_interval, settle;
+         std::mt19937 rng;
+         int elapsed;
+         int arm;                       // 0: A, 1: B
+         int interval_length;
+         int interval_elapsed;
+         bool pair_started;             // the other arm still has to play in the current pair
+         bool running;
+         std::map<unsigned, std::map<std::string, double>> interval_sums;
+         int interval_count;
+         std::map<unsigned, std::map<std::string, running_stats>> stats[2];
+         int next_interval_length();
+
+      public:
+         Experiment();
+         int start(int _duration, int _min_interval, int _max_interval, int _settle, unsigned seed);
+         int add_sample(const std::map<unsigned, std::map<std::string, double>>& sample);
+         bool is_running();
+         int get_arm();
+         int get_elapsed();
+         int get_duration();
+         std::vector<experiment_row> report(double confidence);
+         void write_report(const std::string& file_path, const std::string& config_a, const std::string& config_b, double confidence);
+   };
+}
+
+#endif //cachetuna_experiment_hpp
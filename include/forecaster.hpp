@@ -0,0 +1,82 @@
+#ifndef CACHETUNA_FORECASTER_HPP
+#define CACHETUNA_FORECASTER_HPP
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Autotuna {
+   // per second averages over a rollup bucket
+   struct demand_forecast {
+      bool valid;
+      double misses;
+      double llc;
+   };
+
+   struct rollup {
+      int64_t start;          // seconds since epoch, multiple of the bucket length
+      double misses;
+      double llc;
+      bool has_forecast;
+      double forecast_misses; // predicted before the bucket started
+      double forecast_llc;
+   };
+
+   /* Additive Holt-Winters with a damped trend over one rollup series
+    * The first season fills the seasonal components, forecasts only use them afterwards.
+   */
+   struct holt_winters {
+      double level = 0.0;
+      double trend = 0.0;
+      std::vector<double> season;
+      size_t count = 0;
+      int64_t last_index = 0;
+      void update(double value, int64_t index, double alpha, double beta, double gamma, double phi);
+      double forecast(int64_t index, double phi) const;
+   };
+
+   /* Demand forecaster per cos over long-term rollups
+    * 1 Hz samples are averaged into buckets (5 minutes by default), each closed bucket updates a
+    * Holt-Winters model of its misses and occupancy with a seasonal period of a day, so the
+    * diurnal ramps seen yesterday are expected again. Rollups are kept for a week and persisted,
+    * the models are rebuilt from them on load.
+   */
+   class Forecaster {
+      private:
+         struct cos_state {
+            int64_t open_start = -1;
+            double misses_sum = 0.0;
+            double llc_sum = 0.0;
+            size_t open_count = 0;
+            holt_winters misses_model;
+            holt_winters llc_model;
+            std::deque<rollup> rollups;
+         };
+         int64_t bucket_seconds;
+         size_t season_length;
+         double alpha, beta, gamma, phi;
+         std::map<unsigned, cos_state> states;
+         void close_bucket(cos_state& state, const rollup& bucket);
+         bool is_seasonal(const cos_state& state) const;
+
+      public:
+         Forecaster(int64_t _bucket_seconds = 300, int64_t _season_seconds = 86400, double _alpha = 0.3, double _beta = 0.05, double _gamma = 0.2, double _phi = 0.98);
+         void configure(int64_t _bucket_seconds, int64_t _season_seconds, double _alpha, double _beta, double _gamma, double _phi);
+         bool add_sample(unsigned cos, int64_t timestamp, double misses, double llc);
+         demand_forecast forecast(unsigned cos, int64_t from, int64_t to) const;
+         demand_forecast forecast_at(unsigned cos, int64_t timestamp) const;
+         double get_error(unsigned cos) const;
+         void clear(unsigned cos);
+         void load(const std::string& file_path, int64_t now);
+         void save(const std::string& file_path) const;
+   };
+}
+
+#endif //cachetuna_forecaster_hpp
@@ -9,6 +9,7 @@
 
 // Cachetuna
 #include "misc.hpp"
+#include "series_index.hpp"
 
 class Graph {
    private:
@@ -21,12 +22,16 @@ class Graph {
       double get_y_scale(uint64_t max);
       ftxui::Element get_y_labels(double scale);
       ftxui::GraphFunction bar_graph_function(const std::vector<uint64_t>& data,double scale);
-      ftxui::Canvas line_plot_function(std::vector<std::vector<uint64_t>> mon_data_vec, const std::vector<unsigned> index_vec, uint64_t max, uint64_t min);
+      int datum_width; // line plot spacing of one sample per column
+      int min_column_width; // densest line plot when zoomed out
+      int canvas_width; // line plot canvas of the last frame
+      void draw_line_plot(ftxui::Canvas& canvas, const std::vector<plot_series>& series_vec, double max_scale, size_t num_columns);
 
    public:
       Graph(const std::string& _title, const std::string& _data_type);
-      ftxui::Element get_graph(const std::vector<uint64_t> data); // bar graph
-      ftxui::Element get_graph(const std::vector<std::vector<uint64_t>> mon_data_vec, const std::vector<unsigned> index_vec); // line plot
+      ftxui::Element get_graph(const std::vector<uint64_t>& data); // bar graph
+      plot_view get_view(const plot_window& window);
+      ftxui::Element get_graph(const std::vector<plot_series>& series_vec, const plot_view& view); // line plot, phase boundaries as vertical lines and the forecast dotted
 };
 
 #endif // cachetuna_graph_hpp
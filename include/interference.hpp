@@ -0,0 +1,37 @@
+#ifndef CACHETUNA_INTERFERENCE_HPP
+#define CACHETUNA_INTERFERENCE_HPP
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// cachetuna
+#include "way_mask.hpp"
+
+namespace Autotuna {
+   struct cos_activity {
+      Way_Mask bitmask;
+      std::vector<double> misses;    // same window and alignment for every cos
+      std::vector<double> llc;
+      std::vector<double> bandwidth;
+   };
+
+   struct suspect {
+      unsigned cos;
+      double score;
+   };
+
+   // victim -> suspect -> score in [0, 1]
+   typedef std::map<unsigned, std::map<unsigned, double>> interference_matrix;
+
+   double correlation(const std::vector<double>& x, const std::vector<double>& y);
+   double mask_overlap(const Way_Mask& victim, const Way_Mask& suspect);
+   interference_matrix attribute_interference(const std::map<unsigned, cos_activity>& activity);
+   std::vector<suspect> rank_suspects(const interference_matrix& matrix, unsigned victim);
+}
+
+#endif //cachetuna_interference_hpp
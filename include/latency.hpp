@@ -0,0 +1,81 @@
+#ifndef CACHETUNA_LATENCY_HPP
+#define CACHETUNA_LATENCY_HPP
+
+// std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+// cachetuna
+#include "tracer.hpp"
+
+/* Latency histograms of the tool's own hot paths
+ * One histogram per probe, log-linear buckets (8 per power of two, so within 12.5%) of nanoseconds held in
+ * relaxed atomics: recording from any thread is two clock reads and an atomic add, no locks or allocation.
+*/
+namespace Latency {
+   enum probe {
+      mon_poll,        // pqos_mon_poll
+      l3ca_set,        // pqos_l3ca_set, the MSR writes of the bitmasks
+      alloc_assoc_set, // pqos_alloc_assoc_set, one core
+      process_scan,    // update_processes_vec
+      config_read,     // cachetuna.conf, cache_policy and backup configs
+      config_write,
+      frame_render,
+      num_probes
+   };
+
+   struct summary {
+      uint64_t count;
+      uint64_t p50; // ns
+      uint64_t p99;
+      uint64_t max;
+   };
+
+   class Histogram {
+      private:
+         static constexpr unsigned sub_buckets = 8;
+         static constexpr unsigned num_buckets = 2 * sub_buckets + (64 - 4) * sub_buckets;
+         std::array<std::atomic<uint64_t>, num_buckets> buckets{};
+         std::atomic<uint64_t> max{0};
+         static unsigned get_bucket(uint64_t ns);
+         static uint64_t get_bucket_value(unsigned bucket);
+
+      public:
+         void record(uint64_t ns);
+         summary summarise() const;
+         void clear();
+   };
+
+   const char* get_name(probe p);
+   void record(probe p, uint64_t ns);
+   summary summarise(probe p);
+   void clear();
+
+   // Also a span of the trace when tracing
+   class Scoped_Timer {
+      private:
+         probe p;
+         Tracer::Span span;
+         std::chrono::steady_clock::time_point start;
+
+      public:
+         explicit Scoped_Timer(probe _p) : p(_p), span(get_name(_p)), start(std::chrono::steady_clock::now()) {}
+         ~Scoped_Timer() { record(p, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()); }
+         Scoped_Timer(const Scoped_Timer&) = delete;
+         Scoped_Timer& operator=(const Scoped_Timer&) = delete;
+   };
+
+   // Times a call and passes its return value through, e.g. timed(l3ca_set, pqos_l3ca_set, id, count, table)
+   template <typename Function, typename... Args>
+   auto timed(probe p, Function&& function, Args&&... args) {
+      Scoped_Timer timer(p);
+      return std::forward<Function>(function)(std::forward<Args>(args)...);
+   }
+}
+
+#endif //cachetuna_latency_hpp
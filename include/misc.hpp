@@ -2,8 +2,13 @@
 #define CACHETUNA_MISC_HPP
 
 //std
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <iomanip> // setprecision
+#include <istream>
+#include <map>
+#include <regex>
 #include <set>
 #include <sstream>
 #include <stdio.h>
@@ -12,14 +17,16 @@
 #include <cmath>
 
 namespace Misc {
-	std::vector<std::string> run_cmd(std::string cmd);
-	std::vector<std::string> get_cpu_info();
+	std::vector<std::string> run_cmd(std::string cmd, int timeout = 0);
 	std::string format_bytes(uint64_t bytes);
 	std::string format_misses(uint64_t val);
+	std::string format_duration(uint64_t seconds);
+	std::string format_nanoseconds(uint64_t ns);
 	std::string to_range_extraction(const std::set<int>& numbers);
 	std::string get_executable_path();
-	bool not_contiguous(const std::string& bitmask);
-	unsigned to_decimal(std::string bitmask);
+	std::map<std::string, std::string> read_key_values(const std::string& file_path);
+	std::map<int, std::string> parse_cache_policy_tags(std::istream& file);
+	int get_ps_processor(const std::string& line);
 }
 
 #endif //cachetuna_misc_hpp
@@ -0,0 +1,47 @@
+#ifndef CACHETUNA_MRC_ESTIMATOR_HPP
+#define CACHETUNA_MRC_ESTIMATOR_HPP
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace Autotuna {
+   struct mrc_estimate {
+      std::vector<uint64_t> misses; // estimated misses for 1..num_ways
+      double confidence; // 0 (no usable model) to 1
+   };
+
+   // Fits a miss-rate curve per cos from passively observed (ways, misses) points, without
+   // changing any allocation. Two kinds of points are collected while monitoring:
+   // - occupancy: llc occupancy converted to ways versus misses, from natural fluctuations
+   // - allocation: misses averaged over each period a cos kept the same allocated ways
+   class Mrc_Estimator {
+      private:
+         struct observation {
+            double ways;
+            double misses;
+            double weight;
+         };
+         struct allocation_period {
+            int ways = 0;
+            double misses_sum = 0;
+            size_t count = 0;
+         };
+         size_t max_observations;
+         std::map<unsigned, std::deque<observation>> observations;
+         std::map<unsigned, allocation_period> periods;
+         void add_observation(unsigned cos, const observation& point);
+
+      public:
+         Mrc_Estimator(size_t _max_observations = 3600);
+         void add_sample(unsigned cos, int allocated_ways, double occupied_ways, uint64_t misses);
+         void clear(unsigned cos);
+         mrc_estimate estimate(unsigned cos, int num_ways);
+   };
+}
+
+#endif //cachetuna_mrc_estimator_hpp
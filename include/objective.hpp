@@ -0,0 +1,31 @@
+#ifndef CACHETUNA_OBJECTIVE_HPP
+#define CACHETUNA_OBJECTIVE_HPP
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Autotuna {
+   // How much each metric counts in a cos' objective, misses only by default
+   struct objective_weights {
+      double misses = 1.0;
+      double ipc = 0.0;
+      double bandwidth = 0.0;
+      double external = 0.0; // e.g. p99 latency exposed by the service, lower is better
+   };
+
+   struct objective_sample {
+      double misses = 0.0;
+      double ipc = 0.0;
+      double bandwidth = 0.0; // bytes per second
+      double external = 0.0;
+   };
+
+   bool is_misses_only(const objective_weights& weights);
+   objective_sample average_sample(const std::vector<uint64_t>& misses, const std::vector<double>& ipc, const std::vector<uint64_t>& bandwidth, const std::vector<double>& external, size_t window);
+   double objective_value(const objective_weights& weights, const objective_sample& sample, const objective_sample& reference, double threshold);
+}
+
+#endif //cachetuna_objective_hpp
@@ -0,0 +1,78 @@
+#ifndef CACHETUNA_ONLINE_SEARCH_HPP
+#define CACHETUNA_ONLINE_SEARCH_HPP
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Autotuna {
+   struct search_limits {
+      std::map<unsigned, int> min_ways;
+      std::map<unsigned, int> max_ways;
+   };
+
+   struct search_options {
+      int settle;          // samples discarded after each change
+      int window;          // samples averaged per measurement
+      double abort_margin; // a trial is cut short once its objective exceeds the incumbent's by this fraction
+      double min_gain;     // a trial must beat the incumbent by this fraction to replace it
+      int max_trials;
+      int rebaseline;      // re-measure the incumbent every n trials, as the workload drifts
+   };
+
+   struct search_step {
+      bool apply;                     // true if ways_map must be applied before the next sample
+      std::map<unsigned, int> ways_map;
+   };
+
+   // Bandit-style local search over allocations, measured on the live system.
+   // Starting from an incumbent allocation (the DP's answer), it trials neighbours that move one
+   // way between two cos, one short window at a time, and keeps whichever allocation has shown
+   // the lowest measured objective. Repeated measurements of an allocation are averaged.
+   // Stops when no neighbour of the incumbent improves on it, or after max_trials.
+   class Online_Search {
+      private:
+         struct arm {
+            double sum = 0;
+            int count = 0;
+            double mean() const { return count == 0 ? 0.0 : sum / count; }
+         };
+         search_limits limits;
+         search_options options;
+         std::map<std::map<unsigned, int>, arm> arms;
+         std::map<unsigned, int> incumbent;
+         std::map<unsigned, int> current; // allocation being measured
+         std::vector<std::map<unsigned, int>> candidates;
+         std::set<std::map<unsigned, int>> tried;
+         int num_samples;
+         double window_sum;
+         int window_count;
+         int num_trials;
+         int trials_since_baseline;
+         bool running;
+         bool converged;
+         std::string status;
+         std::vector<std::map<unsigned, int>> neighbours(const std::map<unsigned, int>& center);
+         search_step measure(const std::map<unsigned, int>& ways_map);
+         search_step next_trial();
+         search_step finish(const std::string& reason);
+
+      public:
+         Online_Search();
+         search_step start(const std::map<unsigned, int>& initial, const search_limits& _limits, const search_options& _options);
+         search_step add_sample(double objective);
+         search_step stop();
+         bool is_running();
+         bool has_converged();
+         int get_num_trials();
+         std::map<unsigned, int> get_best();
+         double get_best_objective();
+         std::string get_status();
+   };
+}
+
+#endif //cachetuna_online_search_hpp
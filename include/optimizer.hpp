@@ -0,0 +1,46 @@
+#ifndef CACHETUNA_OPTIMIZER_HPP
+#define CACHETUNA_OPTIMIZER_HPP
+
+// std
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace Autotuna {
+   struct optimizer_problem {
+      int num_cos;
+      int num_ways;              // ways to distribute, each cos gets between min_ways and max_ways
+      std::vector<double> cost;  // num_cos x num_ways, cost[i * num_ways + (w - 1)] is cos i's cost with w ways
+      std::vector<int> min_ways;
+      std::vector<int> max_ways;
+   };
+
+   struct allocation {
+      std::vector<int> ways; // per cos, in problem order
+      double cost;
+   };
+
+   // Distributes ways to minimise the summed cost. Lookup tables are kept between calls,
+   // so reuse one Optimizer rather than constructing one per problem
+   class Optimizer {
+      private:
+         struct entry {
+            double cost;
+            int num_ways;  // ways given to the cos of this row
+            int prev_rank; // rank of the entry in the previous row this one extends
+         };
+         std::vector<entry> table; // (num_cos + 1) x (num_ways + 1) x num_solutions
+         std::vector<int> table_size;
+         bool is_convex(const optimizer_problem& problem);
+         std::vector<allocation> solve_greedy(const optimizer_problem& problem, int num_solutions);
+         std::vector<allocation> solve_dp(const optimizer_problem& problem, int num_solutions);
+
+      public:
+         // Best allocation first, followed by up to num_solutions-1 runner-ups in order of cost.
+         // Empty if the min_ways of all cos don't fit into num_ways.
+         std::vector<allocation> solve(const optimizer_problem& problem, int num_solutions);
+   };
+}
+
+#endif //cachetuna_optimizer_hpp
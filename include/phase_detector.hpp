@@ -0,0 +1,67 @@
+#ifndef CACHETUNA_PHASE_DETECTOR_HPP
+#define CACHETUNA_PHASE_DETECTOR_HPP
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace Autotuna {
+   enum phase_event {
+      PHASE_NONE = 0,
+      PHASE_BOUNDARY = 1,   // a change point was detected, the new phase is not identified yet
+      PHASE_IDENTIFIED = 2, // the new phase's signature is known, matched to a known phase or learned as a new one
+   };
+   // a boundary followed by the same phase is withdrawn as a false alarm
+
+   /* Online change point detection per cos over its misses, occupancy and IPC streams
+    * Each phase starts with a warm-up that sets the reference mean and deviation of every stream,
+    * then a two-sided CUSUM on the standardised (and clipped, misses are spiky) samples flags a
+    * boundary once either sum exceeds h. A phase is identified by its streams' means over its first
+    * signature_length samples, and matched to previously seen phases within a relative tolerance.
+   */
+   class Phase_Detector {
+      private:
+         static const int num_streams = 3;
+         struct stream_state {
+            size_t count = 0;
+            double mean = 0.0;
+            double m2 = 0.0;
+            double g_pos = 0.0;
+            double g_neg = 0.0;
+         };
+         struct cos_state {
+            std::array<stream_state, num_streams> streams;
+            std::array<double, num_streams> phase_sum = {};
+            size_t phase_count = 0;
+            size_t samples_seen = 0;
+            int phase = -1;
+            int previous_phase = -1;
+            std::deque<size_t> boundaries; // sample numbers, since the cos' history started
+         };
+         double k, h;
+         size_t warmup, signature_length, max_boundaries;
+         double tolerance;
+         std::map<unsigned, cos_state> states;
+         std::map<unsigned, std::vector<std::array<double, num_streams>>> signatures; // known phases per cos
+         void start_phase(cos_state& state);
+         int identify(unsigned cos, const std::array<double, num_streams>& signature);
+
+      public:
+         Phase_Detector(double _k = 0.5, double _h = 10.0, size_t _warmup = 60, size_t _signature_length = 90, double _tolerance = 0.25);
+         void configure(double _k, double _h, size_t _warmup, size_t _signature_length, double _tolerance);
+         phase_event add_sample(unsigned cos, double misses, double llc, double ipc);
+         void clear(unsigned cos);
+         void reset(unsigned cos);
+         void skip_sample(unsigned cos);
+         void rebase(unsigned cos);
+         int get_phase(unsigned cos);
+         std::vector<size_t> get_boundaries(unsigned cos, size_t history_size); // indices into the latest history_size samples
+   };
+}
+
+#endif //cachetuna_phase_detector_hpp
@@ -7,7 +7,9 @@
 #include <iostream> // cout
 #include <ostream> // endl
 #include <sstream> // stringstream
+#include <atomic>
 #include <future>
+#include <mutex>
 #include <regex>
 #include <set>
 #include <string>
@@ -15,6 +17,7 @@
 #include <chrono>
 #include <vector>
 #include <numeric>
+#include <limits>
 
 // PQoS
 #include "pqos.h"
@@ -22,9 +25,28 @@
 
 // cachetuna
 #include "misc.hpp" 
+#include "startup.hpp"
+#include "topology.hpp"
+#include "cpu_set.hpp"
+#include "way_mask.hpp"
+#include "latency.hpp"
+#include "tracer.hpp"
 
 // autotuna
 #include "autotuna.hpp"
+#include "autotuna_state.hpp"
+#include "autotuna_cache.hpp"
+#include "shared_ways.hpp"
+#include "controller.hpp"
+#include "mrc_estimator.hpp"
+#include "simulator.hpp"
+#include "online_search.hpp"
+#include "objective.hpp"
+#include "experiment.hpp"
+#include "interference.hpp"
+#include "phase_detector.hpp"
+#include "forecaster.hpp"
+#include "series_index.hpp"
 
 struct L3_Cos {
    unsigned id;
@@ -32,19 +54,31 @@ struct L3_Cos {
    // original settings
    unsigned size;
    std::string tag;
-   std::string bitmask;
+   Way_Mask bitmask;
    std::set<int> cores;
    // new settings
    unsigned new_size;
    std::string new_tag;
-   std::string new_bitmask;
+   Way_Mask new_bitmask;
    std::set<int> new_cores;
    // monitoring data
    std::vector<uint64_t> llc;
    std::vector<uint64_t> misses;
+   Series_Index llc_index; // min/max blocks of llc and misses for the line plots
+   Series_Index misses_index;
+   std::vector<double> ipc;
+   std::vector<uint64_t> bandwidth; // total memory bandwidth, bytes per poll
+   std::vector<double> external; // only recorded when the cos' objective weighs an external signal
    std::vector<std::string> processes; // list of process running on cores
 };
 
+// New settings of a cos, as staged when a trial started
+struct Staged_Cos {
+   std::string tag;
+   Way_Mask bitmask;
+   std::set<int> cores;
+};
+
 class Pqos {
    private:
       struct pqos_config config;
@@ -63,13 +97,103 @@ class Pqos {
       void update_processes_vec();
       std::vector<struct pqos_mon_data*> pqos_mon_data_vec;
       bool start_resource_monitoring();
+      bool init_topology();
       std::set<int> non_contiguous_cos_set; // list of cos with unsaved bit assoc that are non-contiguous
-      std::string way_contention;
+      Way_Mask way_contention;
+      // user settings (cachetuna.conf)
+      std::map<std::string, std::string> settings;
+      void load_settings();
       // autotuna
       int priority_count;
       std::map<unsigned, int> priority_map;
       std::map<unsigned, int> autotuna_min_ways_map;
       std::map<unsigned, std::vector<uint64_t>> cos_misses_matrix;
+      std::map<unsigned, std::vector<uint64_t>> cos_objective_matrix; // same as cos_misses_matrix for misses-only objectives
+      std::map<unsigned, Autotuna::objective_sample> objective_references;
+      Autotuna::objective_sample get_objective_reference(unsigned cos); // history_mutex held
+      double compute_cos_objective(unsigned cos, size_t window, int threshold); // history_mutex held
+      static double read_external_signal(const std::string& file_path, const std::string& cmd, int timeout);
+      // external signals are read off the poll thread, at their own rate
+      struct external_reader {
+         std::future<double> pending;
+         int64_t last_read;
+         double value;
+      };
+      std::map<unsigned, external_reader> external_readers;
+      double sample_external_signal(unsigned cos);
+      bool analysis_touched_hardware;
+      Autotuna::Mrc_Estimator mrc_estimator;
+      std::map<unsigned, double> estimated_curves; // cos -> confidence of the estimate used instead of a sweep
+      Autotuna::Optimizer optimizer;
+      std::vector<Autotuna::tuning_plan> autotuna_plans;
+      std::map<unsigned, Way_Mask> layout_bitmasks(const Autotuna::tuning_plan& plan);
+      void stage_bitmasks(const std::map<unsigned, Way_Mask>& bitmasks);
+      std::recursive_mutex config_mutex; // held while a config is applied to the hardware
+      bool analysis_in_progress;
+      std::map<unsigned, int> analysis_min_ways_map; // minimum needed ways found by the latest analysis
+      // continuous tuning
+      int64_t last_continuous_step;
+      bool layout_unpersisted; // continuous tuning moved ways since cache_policy was last written
+      std::map<unsigned, int64_t> last_way_change;
+      std::string continuous_status;
+      Autotuna::way_loans loans; // ways lent by idle cos, returned when their occupancy climbs
+      double get_way_sensitivity(unsigned cos, int num_ways, double misses);
+      std::string get_loans_summary();
+      // online search
+      Autotuna::Online_Search online_searcher;
+      bool online_search_started;
+      std::string online_search_status;
+      bool apply_search_step(const Autotuna::search_step& step);
+      // canary apply
+      bool canary_active;
+      int64_t canary_start;
+      int canary_window;
+      std::map<unsigned, double> canary_baseline; // protected cos -> objective before the change
+      std::string canary_status;
+      std::vector<Staged_Cos> canary_config; // the new settings under trial, indexed by cos
+      int apply_to_hardware();
+      int commit_changes();
+      void adopt_changes();
+      int write_cache_policy(bool staged);
+      std::string persisted_config; // serialised config last written to cache_policy, empty until the first change
+      std::string serialise_config();
+      void write_config_file(const std::string& file_name, const std::string& config);
+      // A/B experiment
+      Autotuna::Experiment experiment;
+      bool experiment_active;
+      std::string experiment_files[2];
+      std::vector<Way_Mask> experiment_bitmasks[2]; // per arm, indexed by cos
+      std::string experiment_status;
+      std::vector<unsigned> core_assoc_table; // core -> cos in the new settings
+      uint64_t core_assoc_version; // config_version the table was built at
+      int read_config(const std::string& file_name);
+      // interference attribution
+      Autotuna::interference_matrix interference;
+      std::mutex interference_mutex;
+      unsigned interference_poll_count;
+      void update_interference();
+      // phase detection
+      Autotuna::Phase_Detector phase_detector;
+      std::set<unsigned> phase_changes; // cos that entered an identified phase since the last step
+      std::map<std::string, std::map<unsigned, int>> phase_allocations; // phase key -> learned ways
+      std::string phase_status;
+      std::set<unsigned> analysis_targets; // cos a targeted re-analysis sweeps, empty for all cos
+      std::map<unsigned, std::vector<uint64_t>> previous_misses_matrix;
+      std::map<unsigned, std::vector<uint64_t>> previous_objective_matrix;
+      std::string get_phase_key();
+      // demand forecasting
+      Autotuna::Forecaster forecaster;
+      std::mutex forecast_mutex;
+      std::mutex history_mutex; // histories, tags and processes, written off the UI thread
+      std::mutex model_mutex; // mrc_estimator, phase_detector, phase_changes and loans, taken last and never held across calls
+      // render dirty tracking
+      std::atomic<uint64_t> data_version;
+      std::atomic<uint64_t> config_version;
+      void learn_phase_allocation();
+      int apply_experiment_arm(int arm);
+      std::string get_analysis_signature(int threshold, int root_cos, int num_free_ways);
+      int isolate_cos_for_analysis(unsigned cos_id);
+      int measure_cos_misses(unsigned cos_id, int num_ways, int threshold, uint64_t& misses_average, uint64_t& objective_average);
 
    public:
       Pqos();
@@ -82,29 +206,53 @@ class Pqos {
       unsigned get_l3_num_partitions();
       unsigned get_l3_line_size();
       unsigned get_l3cos_count();
+      double get_setting(const std::string& key, double default_val);
+      std::string get_setting_string(const std::string& key, const std::string& default_val);
+      Autotuna::objective_weights get_objective_weights(unsigned cos);
+      bool has_custom_objective(unsigned cos);
+      double get_cos_objective(unsigned cos, size_t window, int threshold);
       int get_num_active_cos();
-      std::string get_way_contention();
+      Way_Mask get_way_contention();
       std::pair<int, int> get_way_contention_index();
       std::vector<struct L3_Cos> get_l3_cos_vec();
+      uint64_t get_data_version();
+      uint64_t get_config_version();
       std::vector<uint64_t> get_cos_llc_vec(int cos);
       std::vector<uint64_t> get_cos_misses_vec(int cos);
       std::set<int> get_bit_assoc(int bit);
+      Way_Mask get_new_bitmask(int cos);
       int get_core_assoc(int core);
       std::vector<unsigned> get_mon_data_index_vec();
-      std::vector<std::vector<uint64_t>> get_all_llc_vec();
-      std::vector<std::vector<uint64_t>> get_all_misses_vec();
+      std::vector<plot_series> get_plot_series(bool misses, const plot_view& view);
+      size_t get_history_length();
       void get_cos_tags();
       int close();
-      void init();
+      void init(Startup_Graph& startup);
       void poll_mon_group();
       bool monInitialised;
       bool run_thread;
       bool monReset;
+      bool is_config_locked();
       void update_new_tag(const std::string& new_tag, int cos);
       void update_new_bitmask(int bit_selected, int cos);
       void update_new_cores(int core_selected, int cos);
+      void update_new_cores(const Cpu_Set& cores_selected, int cos);
+      std::map<unsigned, std::set<int>> get_smt_conflicts(int cos, int threshold);
       void revert_changes();
       int apply_changes();
+      int start_canary(int threshold);
+      int step_canary(int threshold);
+      bool is_canary_active();
+      std::string get_canary_status();
+      int start_experiment(const std::string& file_a, const std::string& file_b);
+      int step_experiment(int threshold);
+      bool is_experiment_active();
+      std::string get_experiment_status();
+      std::vector<Autotuna::experiment_row> get_experiment_report();
+      Autotuna::interference_matrix get_interference_matrix();
+      std::string get_forecast_summary();
+      bool step_phase_tuning(std::set<unsigned>& targets);
+      std::string get_phase_status();
       void backup_config(const std::string& file_name);
       int load_config(const std::string& file_name);
       // AutoTuna
@@ -115,9 +263,24 @@ class Pqos {
       std::map<unsigned, int> get_priority_map();
       std::map<unsigned, int> get_autotuna_min_ways_map();
       std::map<unsigned, std::vector<uint64_t>> get_cos_misses_matrix();
-      void process_autotuna_analysis(int threshold, int root_cos, bool& tuning_feasible, int& depth, int& save_error_code);
+      std::map<unsigned, std::vector<uint64_t>> get_cos_objective_matrix();
+      std::map<unsigned, double> get_estimated_curves();
+      void process_autotuna_analysis(int threshold, int root_cos, bool& tuning_feasible, int& depth, int& save_error_code, std::set<unsigned> targets);
       int run_autotuna_analysis(int threshold, int root_cos, int num_free_ways);
+      void plan_autotuna_tuning(int root_cos);
+      std::vector<Autotuna::tuning_plan> get_autotuna_plans();
       void process_autotuna_tuning(int root_cos, int& depth, int& save_error_code);
+      std::map<unsigned, Way_Mask> get_live_bitmasks();
+      std::map<unsigned, Way_Mask> get_new_bitmasks();
+      std::map<unsigned, Way_Mask> get_plan_bitmasks(size_t plan_index);
+      Autotuna::configuration_prediction predict_configuration(const std::map<unsigned, Way_Mask>& bitmasks, int threshold);
+      bool continuous_tuning;
+      void step_continuous_tuning(int threshold, int root_cos);
+      int persist_layout();
+      std::string get_continuous_status();
+      bool online_search;
+      void step_online_search(int threshold, int root_cos);
+      std::string get_online_search_status();
 };
 
 #endif //cachetuna_pqos_hpp
@@ -0,0 +1,62 @@
+#ifndef CACHETUNA_SERIES_INDEX_HPP
+#define CACHETUNA_SERIES_INDEX_HPP
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct series_span {
+   uint64_t min;
+   uint64_t max;
+   uint64_t last;
+};
+
+// Time range of a line plot
+struct plot_window {
+   size_t span = 0;   // samples in view, 0 to show one sample per column at the default spacing
+   size_t offset = 0; // samples back from the latest one
+};
+
+// Window resolved against the plot's width
+struct plot_view {
+   size_t span;
+   size_t offset;
+   size_t columns;
+};
+
+// Decimated series of a cos, one span per column
+struct plot_series {
+   unsigned cos;
+   std::vector<series_span> columns;
+   std::vector<size_t> markers;   // columns holding a phase boundary
+   std::vector<uint64_t> forecast; // per column, no_value without a forecast
+};
+
+/* Min/max index over a monitoring history
+ * The history (a vector that evicts its oldest samples) is mirrored by push/pop_front, the index keeps
+ * the min and max of every block of block_size samples in a segment tree over a ring of block slots.
+ * span() answers a range from the tree plus at most two partial blocks, so decimating any time range
+ * to a plot's columns costs O(columns * (log blocks + block_size)) instead of O(samples).
+*/
+class Series_Index {
+   private:
+      size_t block_size;
+      size_t num_slots;
+      size_t first_sample; // absolute number of the oldest sample still in the history
+      size_t num_samples;  // samples ever pushed
+      std::vector<uint64_t> tree_min, tree_max; // leaves at [num_slots, 2 * num_slots)
+      void set_leaf(size_t slot, uint64_t min, uint64_t max);
+      void query_slots(size_t from, size_t to, uint64_t& min, uint64_t& max) const;
+
+   public:
+      static constexpr uint64_t no_value = std::numeric_limits<uint64_t>::max();
+      Series_Index(size_t capacity = 86400, size_t _block_size = 64);
+      void push(uint64_t value);
+      void pop_front();
+      void clear();
+      series_span span(const std::vector<uint64_t>& values, size_t first, size_t last) const;
+};
+
+#endif //cachetuna_series_index_hpp
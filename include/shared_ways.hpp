@@ -0,0 +1,22 @@
+#ifndef CACHETUNA_SHARED_WAYS_HPP
+#define CACHETUNA_SHARED_WAYS_HPP
+
+// std
+#include <algorithm>
+#include <cmath> // isfinite
+#include <limits>
+#include <map>
+#include <vector>
+
+// autotuna
+#include "autotuna.hpp"
+#include "optimizer.hpp"
+
+namespace Autotuna {
+   double interpolate_curve(const std::vector<float>& curve, double ways);
+   double contended_cost(const std::vector<float>& head_curve, const std::vector<float>& tail_curve, float head_weight, float tail_weight, int head_ways, int tail_ways, int num_shared);
+   bool compatible_priority(int rank_a, int rank_b, int max_rank);
+   std::vector<tuning_plan> consider_shared_ways(Optimizer& optimizer, const scaled_data& data, const ways_limits& limits, const std::map<unsigned, int>& priority_map, int max_rank, int max_shared, const std::vector<tuning_plan>& plans);
+}
+
+#endif //cachetuna_shared_ways_hpp
@@ -0,0 +1,39 @@
+#ifndef CACHETUNA_SIMULATOR_HPP
+#define CACHETUNA_SIMULATOR_HPP
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// cachetuna
+#include "way_mask.hpp"
+
+// autotuna
+#include "autotuna.hpp"
+#include "shared_ways.hpp"
+
+namespace Autotuna {
+   struct cos_prediction {
+      unsigned cos;
+      bool has_curve;        // false if the cos was not analysed, nothing is predicted for it
+      int num_ways;
+      double effective_ways; // ways left after sharing overlapped ways
+      double misses;
+      uint64_t occupancy;    // bytes
+      double cost;           // priority weighted misses
+   };
+
+   struct configuration_prediction {
+      std::vector<cos_prediction> cos_predictions;
+      double cost;
+      std::vector<std::string> warnings;
+   };
+
+   configuration_prediction predict_configuration(const std::map<unsigned, Way_Mask>& bitmasks, const std::map<unsigned, std::vector<uint64_t>>& curves, const std::map<unsigned, int>& priority_map, const std::map<unsigned, uint64_t>& demand, unsigned way_size, uint64_t threshold);
+   std::vector<std::string> compare_predictions(const configuration_prediction& live, const configuration_prediction& candidate, uint64_t threshold, double max_cost_increase);
+}
+
+#endif //cachetuna_simulator_hpp
@@ -0,0 +1,48 @@
+#ifndef CACHETUNA_STARTUP_HPP
+#define CACHETUNA_STARTUP_HPP
+
+// std
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip> // setprecision
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct stage_timing {
+   std::string name;
+   double start;    // ms since the graph was created
+   double duration; // ms
+   bool succeeded;
+   bool skipped;    // a dependency failed, the stage never ran
+};
+
+/* Startup stages as a dependency graph
+ * A stage starts on its own thread as soon as it is added and waits for its dependencies (added before it),
+ * so independent stages run concurrently. A stage returning false fails its dependents, which are skipped.
+ * Every finished stage appends its timing to the log file.
+*/
+class Startup_Graph {
+   private:
+      std::chrono::steady_clock::time_point created;
+      std::string log_path;
+      std::mutex mutex;
+      std::map<std::string, std::shared_future<bool>> stages;
+      std::vector<stage_timing> timings;
+      double get_elapsed();
+      void record(const stage_timing& timing);
+
+   public:
+      Startup_Graph(const std::string& _log_path);
+      void add_stage(const std::string& name, const std::vector<std::string>& dependencies, const std::function<bool()>& stage);
+      bool wait(const std::string& name);
+      void wait_all();
+      bool is_done(const std::string& name);
+      std::vector<stage_timing> get_timings();
+};
+
+#endif //cachetuna_startup_hpp
@@ -0,0 +1,51 @@
+#ifndef CACHETUNA_TOPOLOGY_HPP
+#define CACHETUNA_TOPOLOGY_HPP
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <cstring> // memcpy
+#include <fstream>
+#include <iomanip> // setw
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include <sys/utsname.h>
+
+// cachetuna
+#include "misc.hpp"
+
+namespace Topology {
+   struct cpu_thread {
+      int core_id;
+      int socket;
+      int l3_domain;       // id of the L3 the cpu shares, -1 without one
+      int numa_node;       // -1 without NUMA
+      std::set<int> siblings; // SMT threads of the same core, the cpu included
+   };
+
+   struct cpu_topology {
+      std::string vendor;
+      std::string model_name;
+      std::string architecture;
+      std::map<int, cpu_thread> cpus; // online cpus
+      std::map<int, std::set<int>> sockets;    // id -> cpus
+      std::map<int, std::set<int>> l3_domains; // id -> cpus
+      std::map<int, std::set<int>> numa_nodes; // id -> cpus
+      int threads_per_core;
+      int cores_per_socket;
+   };
+
+   std::set<int> parse_cpu_list(const std::string& list);
+   cpu_topology read(const std::string& sys_root = "/sys/devices/system/");
+   const cpu_topology& get();
+   std::vector<std::string> describe(const cpu_topology& topology);
+}
+
+#endif //cachetuna_topology_hpp
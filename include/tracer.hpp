@@ -0,0 +1,53 @@
+#ifndef CACHETUNA_TRACER_HPP
+#define CACHETUNA_TRACER_HPP
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip> // setprecision
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h> // getpid
+
+/* Timeline of internal spans and per cos counters, written as a Chrome JSON trace (chrome://tracing, Perfetto)
+ * Every thread appends to its own buffer, the only shared write is the buffer's size published with a release
+ * store, so recording never locks; buffers grow in chunks up to buffer_events and a full one drops its thread's
+ * later events. A thread that exits hands its buffer to the next thread of the same name.
+ * Names are string literals, stored by pointer. Nothing is recorded until start(), the file is written by stop().
+*/
+namespace Tracer {
+   struct event {
+      uint64_t ts;      // ns since start()
+      const char* name;
+      char phase;       // 'B' begin, 'E' end, 'C' counter
+      int cos;          // -1 if the event isn't about a cos
+      double value;     // counter value
+   };
+
+   bool is_enabled();
+   bool start(const std::string& path, size_t buffer_events);
+   bool stop();
+   void set_thread_name(const std::string& name);
+   void begin(const char* name, int cos = -1);
+   void end(const char* name);
+   void counter(const char* name, int cos, double value);
+
+   class Span {
+      private:
+         const char* name;
+         bool active;
+
+      public:
+         explicit Span(const char* _name, int cos = -1) : name(_name), active(is_enabled()) { if (active) begin(name, cos); }
+         ~Span() { if (active) end(name); }
+         Span(const Span&) = delete;
+         Span& operator=(const Span&) = delete;
+   };
+}
+
+#endif //cachetuna_tracer_hpp
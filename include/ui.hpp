@@ -2,8 +2,12 @@
 #define CACHETUNA_UI_HPP
 
 // std
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <iomanip> // setprecision
+#include <map>
 #include <numeric>
 #include <string>
 #include <thread>
@@ -16,7 +20,10 @@
 // cachetuna
 #include "pqos_util.hpp"
 #include "graph.hpp"
+#include "latency.hpp"
 #include "misc.hpp"
+#include "startup.hpp"
+#include "topology.hpp"
 
 // autotuna
 #include "braille_generator.hpp"
@@ -28,6 +35,7 @@ class UserInterface {
 
       /* PQoS */
       Pqos pqos;
+      Startup_Graph startup; // stages still running in the background once the UI shows
 
       /* ftxui */
       // modal
@@ -42,6 +50,7 @@ class UserInterface {
       std::vector<std::string> tab_values;
       ftxui::Component get_tab_toggle();
       // info
+      std::vector<std::string> cpu_info; // written by the cpu_info startup stage
       ftxui::Element cpu_cache_info_hbox();
       // policies Menu options
       int cos_selected;
@@ -58,6 +67,7 @@ class UserInterface {
       ftxui::Element bitmask_window(bool focused);
       // cores settings
       int core_selected;
+      int core_range_anchor; // first core of a range toggled by the next return, -1 without one
       ftxui::Component get_cores_selector();
       ftxui::Element cores_window(bool focused);
       // process list
@@ -79,13 +89,25 @@ class UserInterface {
       bool tuning_feasible;
       bool analysis_completed;
       ftxui::Element analysis_report();
+      ftxui::Element autotuning_plans_report();
+      ftxui::Element prediction_panel(const std::map<unsigned, Way_Mask>& candidate);
+      ftxui::Element experiment_report();
+      ftxui::Element interference_window();
+      // diagnostics tab
+      ftxui::Element diagnostics_window();
       // analyse button 
       ftxui::Component get_analyse_button_selector();
       ftxui::Element analyse_button_texts(bool focused);
+      // phase change re-analysis, requested by poll_data and started by the event loop
+      std::atomic<bool> phase_reanalysis;
+      std::set<unsigned> phase_targets;
       // cos priority
       int priority_cos_selected;
       ftxui::Component get_priority_selector();
       ftxui::Element priority_window(bool focused);
+      // line plots time range
+      plot_window line_plot_window;
+      size_t line_plot_visible; // samples the line plots showed last frame, bounds panning
       // key event handler
       bool KeyCallback(bool tag_focused, bool bitmask_focused, bool cores_focused, bool perf_summary_focused, bool priority_focused, ftxui::ScreenInteractive& screen, ftxui::Event& event);
       // thread for updateFrame
@@ -93,6 +115,27 @@ class UserInterface {
       void poll_data(ftxui::ScreenInteractive &screen);
       // thread for refresh_tuna
       int frame_count;
+      // render caching, panels keyed on the data/config versions of the frame
+      struct panel_cache {
+         std::vector<uint64_t> key;
+         ftxui::Element element;
+      };
+      std::map<std::string, panel_cache> panel_caches;
+      std::atomic<bool> refresh_pending; // a posted Event::Custom not rendered yet
+      uint64_t data_version;
+      uint64_t config_version;
+      uint64_t frame_dimx;
+      uint64_t frame_dimy;
+      ftxui::Element memoise(const std::string& panel, const std::vector<uint64_t>& key, const std::function<ftxui::Element()>& render);
+      ftxui::Element line_plot(Graph& graph, const std::string& panel, bool misses);
+      // frame time counter (SHOW_FRAME_TIME)
+      bool show_frame_time;
+      double frame_time_last;
+      double frame_time_average;
+      uint64_t num_frames;
+      std::deque<double> frame_times;
+      void record_frame_time(double milliseconds);
+      std::string get_frame_time_summary();
 
    public:
       UserInterface();
@@ -0,0 +1,77 @@
+#ifndef CACHETUNA_WAY_MASK_HPP
+#define CACHETUNA_WAY_MASK_HPP
+
+// std
+#include <cstdint>
+#include <string>
+
+/* Cache ways mask of up to 64 ways, as programmed into a class of service
+ * Positions count from the left of the mask as it is shown and written to cache_policy, position 0 being
+ * the highest way (the first DDIO way), so position p is bit num_ways - 1 - p of the hardware mask.
+*/
+class Way_Mask {
+   private:
+      unsigned num_ways;
+      uint64_t bits;
+      constexpr uint64_t full() const { return num_ways >= 64 ? ~uint64_t(0) : (uint64_t(1) << num_ways) - 1; }
+      constexpr uint64_t bit(unsigned pos) const { return pos < num_ways ? uint64_t(1) << (num_ways - 1 - pos) : 0; }
+
+   public:
+      static constexpr unsigned npos = ~0u;
+
+      constexpr Way_Mask() : num_ways(0), bits(0) {}
+      constexpr Way_Mask(uint64_t _bits, unsigned _num_ways) : num_ways(_num_ways > 64 ? 64 : _num_ways), bits(0) { bits = _bits & full(); }
+
+      // count ways from position first
+      static constexpr Way_Mask range(unsigned num_ways, unsigned first, unsigned count) {
+         Way_Mask mask(0, num_ways);
+         for (unsigned pos=first; pos<first + count && pos<mask.num_ways; ++pos) mask.bits |= mask.bit(pos);
+         return mask;
+      }
+      static Way_Mask from_binary(const std::string& binary);
+
+      constexpr uint64_t get_bits() const { return bits; }
+      constexpr unsigned get_num_ways() const { return num_ways; }
+      constexpr bool test(unsigned pos) const { return bits & bit(pos); }
+      constexpr void set(unsigned pos, bool value = true) { bits = value ? bits | bit(pos) : bits & ~bit(pos); }
+      constexpr void flip(unsigned pos) { bits ^= bit(pos); }
+      constexpr bool empty() const { return bits == 0; }
+
+      constexpr unsigned count() const {
+         unsigned total = 0;
+         for (uint64_t rest = bits; rest != 0; rest &= rest - 1) ++total;
+         return total;
+      }
+
+      // leftmost and rightmost set positions, npos when empty
+      constexpr unsigned first() const {
+         for (unsigned pos=0; pos<num_ways; ++pos) if (test(pos)) return pos;
+         return npos;
+      }
+      constexpr unsigned last() const {
+         for (unsigned pos=num_ways; pos>0; --pos) if (test(pos - 1)) return pos - 1;
+         return npos;
+      }
+      constexpr unsigned first_clear() const { return (~*this).first(); }
+
+      // set ways form one run, as CAT requires; an empty mask is contiguous
+      constexpr bool is_contiguous() const {
+         if (bits == 0) return true;
+         uint64_t run = bits;
+         while ((run & 1) == 0) run >>= 1;
+         return (run & (run + 1)) == 0;
+      }
+
+      constexpr bool overlaps(const Way_Mask& other) const { return (bits & other.bits) != 0; }
+      constexpr Way_Mask operator|(const Way_Mask& other) const { return Way_Mask(bits | other.bits, num_ways); }
+      constexpr Way_Mask operator&(const Way_Mask& other) const { return Way_Mask(bits & other.bits, num_ways); }
+      constexpr Way_Mask operator~() const { return Way_Mask(~bits, num_ways); }
+      constexpr Way_Mask& operator|=(const Way_Mask& other) { bits = (bits | other.bits) & full(); return *this; }
+      constexpr bool operator==(const Way_Mask& other) const { return bits == other.bits && num_ways == other.num_ways; }
+      constexpr bool operator!=(const Way_Mask& other) const { return !(*this == other); }
+
+      std::string to_binary() const;
+      std::string to_hex() const;
+};
+
+#endif //cachetuna_way_mask_hpp
@@ -2,12 +2,7 @@
 
 using namespace Autotuna;
 
-float MAX_VALUE = std::numeric_limits<float>::max();
-
-std::string Autotuna::construct_bitmask_str(std::pair<int, int> way_contention_index, int l3_num_ways, int num_active_ways, int pos_0) {
-   std::string bitmask; 
-   std::string active_ways = std::string(num_active_ways, '1');
-
+Way_Mask Autotuna::construct_way_mask(std::pair<int, int> way_contention_index, int l3_num_ways, int num_active_ways, int pos_0) {
    int num_tail_ways = 0;
    int num_head_ways = pos_0;
    int contention_start = way_contention_index.first + 1;
@@ -38,118 +33,173 @@ std::string Autotuna::construct_bitmask_str(std::pair<int, int> way_contention_i
    else {
       num_tail_ways = l3_num_ways - pos_0 - num_active_ways;
    }
-   bitmask = std::string(num_head_ways, '0') + active_ways + std::string(num_tail_ways, '0');
-   return bitmask;
+   return Way_Mask::range(l3_num_ways, num_head_ways, num_active_ways);
+}
+
+// Ways of one member of a group of num_active_ways ways shared by overlapping cos,
+// the member's ways start member_offset ways into the group
+Way_Mask Autotuna::construct_way_mask(std::pair<int, int> way_contention_index, int l3_num_ways, int num_active_ways, int pos_0, int member_offset, int member_ways) {
+   unsigned group_start = construct_way_mask(way_contention_index, l3_num_ways, num_active_ways, pos_0).first();
+   if (group_start == Way_Mask::npos) return Way_Mask(0, l3_num_ways);
+   return Way_Mask::range(l3_num_ways, group_start + member_offset, member_ways);
+}
+
+/* Move one way from donor to receiver in place: the donor gives up its way facing the receiver, the receiver
+ * takes the way next to it and only the cos in between shift one way towards the donor, the rest keep their ways.
+ * Empty when the masks aren't disjoint and contiguous or the move would break the DDIO or contention rules.
+*/
+std::map<unsigned, Way_Mask> Autotuna::move_one_way(const std::map<unsigned, Way_Mask>& bitmasks, std::pair<int, int> way_contention_index, unsigned donor, unsigned receiver) {
+   auto donor_entry = bitmasks.find(donor);
+   auto receiver_entry = bitmasks.find(receiver);
+   if (donor == receiver || donor_entry == bitmasks.end() || receiver_entry == bitmasks.end() || donor_entry->second.count() < 2) return {};
+
+   unsigned num_ways = donor_entry->second.get_num_ways();
+   Way_Mask used_bitmask(0, num_ways);
+   for (const auto&[cos, bitmask] : bitmasks) {
+      if (bitmask.empty() || !bitmask.is_contiguous() || bitmask.get_num_ways() != num_ways || used_bitmask.overlaps(bitmask)) return {};
+      used_bitmask |= bitmask;
+   }
+
+   std::map<unsigned, Way_Mask> moved = bitmasks;
+   bool towards_left = donor_entry->second.first() < receiver_entry->second.first();
+   Way_Mask& donor_mask = moved[donor];
+   donor_mask.set(towards_left ? donor_mask.last() : donor_mask.first(), false);
+
+   // push the cos next to the receiver towards the donor until a free way, at the latest the donor's, is reached
+   std::vector<unsigned> pushed;
+   unsigned pos = towards_left ? receiver_entry->second.first() - 1 : receiver_entry->second.last() + 1;
+   while (true) {
+      auto owner = std::find_if(moved.begin(), moved.end(), [&](const auto& entry) { return entry.second.test(pos); });
+      if (owner == moved.end()) break;
+      pushed.push_back(owner->first);
+      pos = towards_left ? owner->second.first() - 1 : owner->second.last() + 1;
+   }
+   for (unsigned cos : pushed) {
+      const Way_Mask& bitmask = moved[cos];
+      moved[cos] = Way_Mask::range(num_ways, towards_left ? bitmask.first() - 1 : bitmask.first() + 1, bitmask.count());
+   }
+   Way_Mask& receiver_mask = moved[receiver];
+   receiver_mask.set(towards_left ? receiver_mask.first() - 1 : receiver_mask.last() + 1);
+
+   for (const auto&[cos, bitmask] : moved) {
+      if (bitmask == bitmasks.at(cos)) continue;
+      // DDIO Mask -- first two bits must be the same
+      if (num_ways >= 2 && bitmask.test(0) != bitmask.test(1)) return {};
+      // as construct_way_mask, a mask must not end inside the contention ways
+      int last = static_cast<int>(bitmask.last());
+      if (last >= way_contention_index.first && last < way_contention_index.second) return {};
+   }
+   return moved;
+}
+
+float Autotuna::normalise_priority_ranking(int rank, const std::map<unsigned, int>& priority_map) {
+   if (rank == 0) return 1.0;
+   auto max_rank = std::max_element(priority_map.begin(), priority_map.end(), [](const auto &x, const auto &y) 
+                   { return x.second < y.second; });
+   float weight = ((float)rank - 0.0) / ((float)max_rank->second - 0.0);
+   return weight;
 }
 
 scaled_data Autotuna::scale_misses_matrix(const std::map<unsigned, std::vector<uint64_t>>& cos_misses_matrix, std::map<unsigned, int>& priority_map) {
    scaled_data data;
 
-   auto normalise_priority_ranking = [&](int rank) -> float {
-      if (rank == 0) return 1.0;
-      auto max_rank = std::max_element(priority_map.begin(), priority_map.end(), [](const auto &x, const auto &y) 
-                      { return x.second < y.second; });
-      float weight = ((float)rank - 0.0) / ((float)max_rank->second - 0.0);
-      return weight;
-   };
-
    for (const auto&[cos, misses_vec] : cos_misses_matrix) {
       // scale cos_misses_matrix by the weight calculated based on each cos' priority rankings 
-      float weight = normalise_priority_ranking(priority_map[cos]);
+      float weight = normalise_priority_ranking(priority_map[cos], priority_map);
       std::vector<float> scaled_vec(misses_vec.begin(), misses_vec.end());
       std::transform(scaled_vec.begin(), scaled_vec.end(), scaled_vec.begin(), [weight](uint64_t x) { return weight * (float)x; });
       // populate scaled_data struct
       data.matrix.push_back(scaled_vec);
       data.order.push_back(cos); 
+      data.weights.push_back(weight);
    }
    return data;
 }
 
-void Autotuna::adjust_misses_matrix_values(scaled_data& data, const std::map<unsigned, int>& min_ways_map, int root_cos, int remaining_ways) {
-   // Adjust scaled matrix's values based on each cos' minimum needed ways to prune dynamic programming
-   for (const auto&[cos, min_ways] : min_ways_map) {
-      if (cos == root_cos) continue;
-
-      size_t start, end;
-      int cos_index = std::distance(data.order.begin(), std::find(data.order.begin(), data.order.end(), cos));
-
-      if (remaining_ways < 0) {
-         start = min_ways;
-         end = data.matrix[cos_index].size();
+ways_limits Autotuna::get_ways_limits(const scaled_data& data, const std::map<unsigned, int>& min_ways_map, int remaining_ways) {
+   // Bound each cos by its minimum needed ways to prune the optimisation
+   ways_limits limits;
+   int num_ways = data.matrix.empty() ? 0 : data.matrix[0].size();
+   for (const unsigned& cos : data.order) {
+      auto min_ways = min_ways_map.find(cos);
+      int needed = min_ways == min_ways_map.end() ? 1 : min_ways->second;
+      if (remaining_ways < 0) { // not enough ways for every cos' minimum, never give more than needed
+         limits.min_ways[cos] = 1;
+         limits.max_ways[cos] = needed;
       }
       else {
-         start = 0;
-         end = min_ways - 1;
+         limits.min_ways[cos] = needed;
+         limits.max_ways[cos] = num_ways;
       }
-      for (start; start < end; ++start) data.matrix[cos_index][start] = MAX_VALUE;
    }
+   return limits;
 }
 
-void Autotuna::calculate_optimal_ways_combination(const scaled_data& data, std::map<unsigned, int>& min_ways_map, const std::map<unsigned, int>& priority_map, int root_cos) {
-   struct Allocation {
-      float misses;
-      int num_ways;
-   };
-
-   // Construct a (n+1)x(W+1) lookup table T to store previously calculated Allocation values
-   int n = data.matrix.size();
-   int W = data.matrix[0].size();
-   Allocation initial_values = {MAX_VALUE, 0};
-   std::vector<std::vector<Allocation>> T(n + 1, std::vector<Allocation>(W + 1, initial_values));
-
-   // Fill 0th row of T with misses = 0.0 and num_ways = 0
-   for (int j=0; j<T[0].size(); ++j) {
-      T[0][j].misses = 0.0;
-   }
-
-   // Populate T
-   for (int i=1; i<=n; ++i) {
-      for (int j=1; j<=W; ++j) {
-         for (int k=1; k<=j; ++k) {
-            float curr_misses = data.matrix[i-1][k-1];
-            float total_misses = curr_misses + T[i-1][j-k].misses;
-            if (total_misses < T[i][j].misses) {
-               T[i][j].misses = total_misses;
-               T[i][j].num_ways = k;
-            }
-         }
+/* Hand out ways the optimizer left unallocated (cos with no misses gain nothing from more ways) a portion at a time
+ * in the order given, never past a receiver's max ways; a capped receiver's share carries over to the next one.
+ * Returns the ways no receiver had room for.
+*/
+int Autotuna::distribute_leftover_ways(std::vector<int>& ways, const std::vector<int>& max_ways, int leftover) {
+   while (leftover > 0) {
+      int num_open = 0;
+      for (size_t i=0; i<ways.size(); ++i) if (ways[i] < max_ways[i]) ++num_open;
+      if (num_open == 0) break;
+      int portion = (leftover + num_open - 1) / num_open;
+      for (size_t i=0; i<ways.size() && leftover > 0; ++i) {
+         int extra = std::min({leftover, portion, std::max(0, max_ways[i] - ways[i])});
+         ways[i] += extra;
+         leftover -= extra;
       }
    }
+   return leftover;
+}
 
-   // Backtrack on lookup table T to retrive the calculated optimal num_ways for each cos
-   int ways = W;
-   for (int cos = n; cos >= 1; cos--) {
-      unsigned cos_id = data.order[cos-1];
-      min_ways_map[cos_id] = T[cos][ways].num_ways;
-      ways -= T[cos][ways].num_ways; 
+std::vector<tuning_plan> Autotuna::calculate_optimal_ways_combination(Optimizer& optimizer, const scaled_data& data, const ways_limits& limits, const std::map<unsigned, int>& priority_map, int root_cos, int num_solutions) {
+   // Flatten scaled matrix into the optimizer's n x W cost array
+   optimizer_problem problem;
+   problem.num_cos = data.matrix.size();
+   problem.num_ways = data.matrix.empty() ? 0 : data.matrix[0].size();
+   problem.cost.reserve(problem.num_cos * problem.num_ways);
+   for (size_t i=0; i<data.matrix.size(); ++i) {
+      unsigned cos = data.order[i];
+      problem.cost.insert(problem.cost.end(), data.matrix[i].begin(), data.matrix[i].end());
+      problem.min_ways.push_back(std::clamp(limits.min_ways.at(cos), 1, problem.num_ways));
+      problem.max_ways.push_back(std::clamp(limits.max_ways.at(cos), problem.min_ways.back(), problem.num_ways));
    }
 
    // Handle the case where there are extra unallocated ways due to numerous cos with 0 misses
    auto sort_by_rank = [&](const std::pair<unsigned, int>& a, const std::pair<unsigned, int>& b) -> bool {
       return (a.second < b.second);
    };
-
-   if (ways > 0) {
-      // sort cos by priority rank
-      std::vector<std::pair<unsigned, int>> sorted_priority_vec;
-      for (const auto&[cos, rank] : priority_map) {
-         if (cos == root_cos) continue;
-         sorted_priority_vec.push_back(std::make_pair(cos, rank));
+   std::vector<std::pair<unsigned, int>> sorted_priority_vec;
+   for (const auto&[cos, rank] : priority_map) {
+      if (cos == root_cos || std::find(data.order.begin(), data.order.end(), cos) == data.order.end()) continue;
+      sorted_priority_vec.push_back(std::make_pair(cos, rank));
+   }
+   sort(sorted_priority_vec.begin(), sorted_priority_vec.end(), sort_by_rank);
+
+   std::vector<tuning_plan> plans;
+   for (const allocation& solution : optimizer.solve(problem, num_solutions)) {
+      tuning_plan plan;
+      plan.cost = solution.cost;
+      int ways = problem.num_ways;
+      for (int i=0; i<problem.num_cos; ++i) {
+         plan.ways_map[data.order[i]] = solution.ways[i];
+         ways -= solution.ways[i];
       }
-      sort(sorted_priority_vec.begin(), sorted_priority_vec.end(), sort_by_rank);
-
-      // allocate extra ways to each cos by portion
-      int portion = std::ceil(ways / n);
-      for (const auto& cos : sorted_priority_vec) {
-         unsigned cos_id = cos.first;
-         if (ways == 0) { 
-            continue;
-         } else if (ways < portion) {
-            min_ways_map[cos_id] += ways;
-         } else {
-            min_ways_map[cos_id] += portion;
+
+      // allocate extra ways to each cos by portion, within its max ways
+      if (ways > 0 && !sorted_priority_vec.empty()) {
+         std::vector<int> cos_ways, cos_max_ways;
+         for (const auto& cos : sorted_priority_vec) {
+            size_t index = std::find(data.order.begin(), data.order.end(), cos.first) - data.order.begin();
+            cos_ways.push_back(plan.ways_map[cos.first]);
+            cos_max_ways.push_back(problem.max_ways[index]);
          }
-         ways -= portion;
+         distribute_leftover_ways(cos_ways, cos_max_ways, ways);
+         for (size_t i=0; i<sorted_priority_vec.size(); ++i) plan.ways_map[sorted_priority_vec[i].first] = cos_ways[i];
       }
+      plans.push_back(plan);
    }
-} 
+   return plans;
+}
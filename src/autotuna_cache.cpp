@@ -0,0 +1,93 @@
+#include "autotuna_cache.hpp"
+
+using namespace Autotuna;
+
+/* Curve database layout, one workload per line
+ * <fingerprint> <timestamp> <misses with 1 way>,<misses with 2 ways>,...
+*/
+
+std::string Autotuna::workload_fingerprint(const std::vector<std::string>& processes, size_t num_cores) {
+   // Keep only the command column of "ps ao user,pid,pcpu,pmem,psr,stat,start,time,command",
+   // pids and cpu usage change between runs of the same workload
+   std::set<std::string> commands;
+   for (const std::string& process : processes) {
+      std::istringstream iss(process);
+      std::string field;
+      for (int i=0; i<8 && iss >> field; ++i);
+      std::string command;
+      std::getline(iss >> std::ws, command);
+      while (!command.empty() && (command.back() == '\n' || command.back() == ' ')) command.pop_back();
+      // skip the process scan pipeline itself
+      if (command.empty() || command.rfind("ps ao", 0) == 0 || command.rfind("awk ", 0) == 0 || command.rfind("sh -c ps ao", 0) == 0) continue;
+      commands.insert(command);
+   }
+
+   // FNV-1a, stable across builds unlike std::hash
+   uint64_t hash = 14695981039346656037ULL;
+   auto add = [&hash](const std::string& str) {
+      for (const char& c : str) {
+         hash ^= static_cast<unsigned char>(c);
+         hash *= 1099511628211ULL;
+      }
+      hash ^= '\n';
+      hash *= 1099511628211ULL;
+   };
+   add(std::to_string(num_cores));
+   for (const std::string& command : commands) add(command);
+
+   std::ostringstream oss;
+   oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+   return oss.str();
+}
+
+std::map<std::string, cached_curve> Autotuna::load_curve_cache(const std::string& file_path) {
+   std::map<std::string, cached_curve> cache;
+   std::ifstream infile(file_path);
+   std::string line;
+
+   while (std::getline(infile, line)) {
+      std::istringstream iss(line);
+      std::string fingerprint, misses_str;
+      cached_curve curve;
+      if (!(iss >> fingerprint >> curve.timestamp >> misses_str)) continue;
+
+      std::istringstream misses_iss(misses_str);
+      std::string misses;
+      try {
+         while (std::getline(misses_iss, misses, ',')) {
+            curve.misses.push_back(std::stoull(misses));
+         }
+      } catch (const std::exception&) {
+         continue; // truncated or corrupt line
+      }
+      if (!curve.misses.empty()) cache[fingerprint] = curve;
+   }
+   return cache;
+}
+
+void Autotuna::store_curve(const std::string& file_path, const std::string& fingerprint, const std::vector<uint64_t>& misses) {
+   std::map<std::string, cached_curve> cache = load_curve_cache(file_path);
+   cache[fingerprint] = {now_seconds(), misses};
+
+   std::ofstream outfile(file_path, std::ios::out | std::ios::trunc);
+   if (!outfile.is_open()) return;
+
+   for (const auto&[key, curve] : cache) {
+      outfile << key << " " << curve.timestamp << " ";
+      for (size_t i=0; i<curve.misses.size(); ++i) {
+         outfile << curve.misses[i] << (i + 1 < curve.misses.size() ? "," : "");
+      }
+      outfile << "\n";
+   }
+}
+
+// Check a cached curve against the misses observed live at the cos' current number of ways
+bool Autotuna::curve_matches(const std::vector<uint64_t>& misses, int num_ways, uint64_t live_misses, uint64_t threshold, double tolerance) {
+   if (misses.empty() || num_ways < 1) return false;
+
+   uint64_t predicted = misses[std::min(static_cast<size_t>(num_ways), misses.size()) - 1];
+   // relative to the prediction, but never tighter than the misses threshold itself
+   double allowed = tolerance * static_cast<double>(std::max(predicted, threshold));
+   double difference = static_cast<double>(predicted > live_misses ? predicted - live_misses : live_misses - predicted);
+   return difference <= allowed;
+}
@@ -0,0 +1,56 @@
+#include "autotuna_state.hpp"
+
+using namespace Autotuna;
+
+/* State file layout
+ * SIGNATURE=<topology and analysis config the measurements belong to>
+ * <cos> <num_ways> <timestamp> <misses_average> [<objective_average>]
+ * ...
+ * One measurement line is appended as soon as a way count has been measured,
+ * so an interrupted analysis loses at most the way count under test.
+*/
+
+int64_t Autotuna::now_seconds() {
+   return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+analysis_state Autotuna::load_analysis_state(const std::string& file_path, const std::string& signature, int64_t max_age) {
+   analysis_state state;
+   std::ifstream infile(file_path);
+   std::string line;
+
+   // Measurements taken on a different topology or analysis config can't be reused
+   if (!std::getline(infile, line) || line != "SIGNATURE=" + signature) return state;
+
+   int64_t now = now_seconds();
+   while (std::getline(infile, line)) {
+      std::istringstream iss(line);
+      unsigned cos;
+      int num_ways;
+      measurement point;
+      if (!(iss >> cos >> num_ways >> point.timestamp >> point.misses)) continue;
+      if (!(iss >> point.objective)) point.objective = point.misses;
+      if (now - point.timestamp > max_age) continue; // expired
+      state[cos][num_ways] = point;
+   }
+   return state;
+}
+
+void Autotuna::save_analysis_state(const std::string& file_path, const std::string& signature, const analysis_state& state) {
+   std::ofstream outfile(file_path, std::ios::out | std::ios::trunc);
+   if (!outfile.is_open()) return;
+
+   outfile << "SIGNATURE=" << signature << "\n";
+   for (const auto&[cos, points] : state) {
+      for (const auto&[num_ways, point] : points) {
+         outfile << cos << " " << num_ways << " " << point.timestamp << " " << point.misses << " " << point.objective << "\n";
+      }
+   }
+}
+
+void Autotuna::append_analysis_state(const std::string& file_path, unsigned cos, int num_ways, uint64_t misses, uint64_t objective) {
+   std::ofstream outfile(file_path, std::ios::out | std::ios::app);
+   if (!outfile.is_open()) return;
+
+   outfile << cos << " " << num_ways << " " << now_seconds() << " " << misses << " " << objective << "\n";
+}
@@ -9,104 +9,174 @@
 
 using namespace Braille_Generator;
 
-std::vector<std::string> Braille_Generator::generate_braille(int width_w, int height_w, const char *filename) { // width_w divisible by 2; height_w divisible by 4
-    int width, height, bpp;
-
-    uint8_t* rgb_image = stbi_load(filename, &width, &height, &bpp, 1);
-
-    uint8_t* rgb_image_w;
-
-    rgb_image_w = static_cast<uint8_t *>(malloc(width_w * height_w * 1));
-
-    stbir_resize_uint8(rgb_image, width, height, 0,
-                       rgb_image_w, width_w, height_w, 0,
-                       1);
-
-    stbi_image_free(rgb_image); // free original
-
-    auto* dithered = static_cast<uint8_t *>(malloc(width_w * height_w * 1));
-
-    for ( int i = 0; i < height_w; i++ ) {
-        for (int j =0; j < width_w; j++){
-            *(dithered + (i*width_w + j)) = *(rgb_image_w + (i*width_w + j)) < 128 ? 0 : 255 ;
-            auto error_diffuse = (*(rgb_image_w + (i*width_w + j)) - *(dithered + (i*width_w + j)))/16.0;
-
-            if (j < width_w-1){ // right col exists
-                *(rgb_image_w + (i*width_w + j+1)) += (uint8_t) error_diffuse*7;
-            }
-            if (i < height_w-1){ //bottom row exists
-                *(rgb_image_w + ((i+1)*width_w + j)) += (uint8_t) error_diffuse*5;
-
-                if (j != 0){ // left col exists
-                    *(rgb_image_w + ((i+1)*width_w + j-1)) += (uint8_t) error_diffuse*3;
-                }
-                if (j < width_w-1){ // right col exists
-                    *(rgb_image_w + ((i+1)*width_w + j+1)) += (uint8_t) error_diffuse*1;
-                }
-            }
-        }
-    }
-
-    free(rgb_image_w); // free resized
-
-    std::vector<std::string> out;
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    for ( int i = 0; i < height_w; i+=4 ) {
-       std::string line;
-        for (int j =0; j < width_w; j+=2){
-            std::string bits;
-            for (int braille_w = 0; braille_w<2;++braille_w){ // 1, 2, 3, 4, 5, 6
-                for (int braille_h = 0; braille_h<3;++braille_h){
-                    if (*(dithered + ((i+braille_h)*width_w + j+braille_w)) == 0){
-                        bits.push_back('1');
-                    } else{
-                        bits.push_back('0');
-                    }
-                }
-            }
-            if (*(dithered + ((i+3)*width_w + j+0)) == 0){ // 7
-                bits.push_back('1');
-            } else{
-                bits.push_back('0');
-            }
-            if (*(dithered + ((i+3)*width_w + j+1)) == 0){ // 8
-                bits.push_back('1');
-            } else{
-                bits.push_back('0');
-            }
-
-            std::reverse(bits.begin(), bits.end());
-
-            std::bitset<24>  offset(bits);
-            std::bitset<24>  val((int)(offset.to_ulong()) + 10240);
-            std::stringstream ss;
-            ss << std::hex << std::uppercase  << val.to_ulong();
-            std::string braille_symbol =  ss.str();
-
-            int code_point = std::stoi (braille_symbol, nullptr, 16);
-            std::wstring wide_str = {static_cast<wchar_t>(code_point)};
-            std::string utf8_str = converter.to_bytes(wide_str);
-
-
-            line.append(utf8_str);
-        }
-        out.push_back(line);
-    }
-
-    free(dithered);
-
-    return out;
+/* UTF-8 of the 256 braille patterns (U+2800 + dots), bit n set for dot n+1:
+ * dots 1-3 and 7 run down the left column, dots 4-6 and 8 down the right one
+*/
+const std::array<std::string, 256>& Braille_Generator::braille_table() {
+   static const std::array<std::string, 256> table = [] {
+      std::array<std::string, 256> utf8;
+      for (unsigned dots=0; dots<256; ++dots) {
+         unsigned code_point = 0x2800 + dots;
+         utf8[dots] = {static_cast<char>(0xE0 | (code_point >> 12)),
+                       static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)),
+                       static_cast<char>(0x80 | (code_point & 0x3F))};
+      }
+      return utf8;
+   }();
+   return table;
 }
 
-std::vector<std::vector<std::string>> Braille_Generator::generate_all_frames(int width, int height, const std::string& directory, int frame_count) {
-   std::vector<std::vector<std::string>> frames;
-    for (int i = 0; i<frame_count; ++i){
-        std::string filename = directory+std::to_string(i)+".png";
-        std::vector<std::string> out = generate_braille(width,height,filename.c_str());
-        frames.push_back(out);
-    }
-    return frames;
+/* Floyd-Steinberg dithering to 0 (dot) / 255, in integers
+ * The error of the current and next row lives in two int16 rows scaled by 16, so pixels never wrap around
+ * like they do when the error is added back into the uint8 image.
+*/
+std::vector<uint8_t> Braille_Generator::dither(const uint8_t* gray, int width, int height) {
+   std::vector<uint8_t> dithered(static_cast<size_t>(width) * height);
+   std::vector<int16_t> error_rows[2] = {std::vector<int16_t>(width + 2, 0), std::vector<int16_t>(width + 2, 0)};
+
+   for (int i=0; i<height; ++i) {
+      std::vector<int16_t>& current = error_rows[i % 2];
+      std::vector<int16_t>& next = error_rows[(i + 1) % 2];
+      std::fill(next.begin(), next.end(), 0);
+      const uint8_t* row = gray + static_cast<size_t>(i) * width;
+      uint8_t* out = dithered.data() + static_cast<size_t>(i) * width;
+      // current[j + 1] holds pixel j, the padding absorbs the edges' diffusion
+      for (int j=0; j<width; ++j) {
+         int value = std::clamp(row[j] + current[j + 1] / 16, 0, 255);
+         out[j] = value < 128 ? 0 : 255;
+         int error = value - out[j];
+         current[j + 2] += error * 7;
+         next[j] += error * 3;
+         next[j + 1] += error * 5;
+         next[j + 2] += error;
+      }
+   }
+   return dithered;
 }
 
-#define NUMBER_OF_FRAMES 10
-#define ANIMATION_DIR "Tuna/"
+// One braille glyph per 2x4 block, blocks past the image's edges are blank
+std::vector<std::string> Braille_Generator::encode(const std::vector<uint8_t>& dots, int width, int height) {
+   static const int dot_bit[4][2] = {{0, 3}, {1, 4}, {2, 5}, {6, 7}}; // [row][column]
+   const std::array<std::string, 256>& table = braille_table();
+   std::vector<std::string> lines;
+   for (int i=0; i<height; i+=4) {
+      std::string line;
+      line.reserve(3 * ((width + 1) / 2));
+      for (int j=0; j<width; j+=2) {
+         unsigned glyph = 0;
+         for (int row=0; row<4 && i+row<height; ++row) {
+            const uint8_t* pixels = dots.data() + static_cast<size_t>(i + row) * width + j;
+            glyph |= (pixels[0] == 0) << dot_bit[row][0];
+            if (j + 1 < width) glyph |= (pixels[1] == 0) << dot_bit[row][1];
+         }
+         line += table[glyph];
+      }
+      lines.push_back(std::move(line));
+   }
+   return lines;
+}
+
+std::vector<std::string> Braille_Generator::generate_braille(int width_w, int height_w, const char *filename) {
+   if (width_w <= 0 || height_w <= 0) return {};
+   int width, height, bpp;
+   uint8_t* image = stbi_load(filename, &width, &height, &bpp, 1);
+   if (image == NULL) return {};
+
+   std::vector<uint8_t> resized(static_cast<size_t>(width_w) * height_w);
+   stbir_resize_uint8(image, width, height, 0, resized.data(), width_w, height_w, 0, 1);
+   stbi_image_free(image);
+
+   return encode(dither(resized.data(), width_w, height_w), width_w, height_w);
+}
+
+frames Braille_Generator::generate_all_frames(int width, int height, const std::string& directory, int frame_count) {
+   frames all_frames;
+   for (int i = 0; i<frame_count; ++i){
+      std::string filename = directory+std::to_string(i)+".png";
+      std::vector<std::string> out = generate_braille(width,height,filename.c_str());
+      if (!out.empty()) all_frames.push_back(std::move(out));
+   }
+   return all_frames;
+}
+
+Frame_Cache::Frame_Cache(const std::string& _directory, int _frame_count) :
+   directory(_directory),
+   frame_count(_frame_count)
+{
+}
+
+std::string Frame_Cache::get_cache_path(int width, int height) {
+   return directory + "cache/" + std::to_string(width) + "x" + std::to_string(height) + ".frames";
+}
+
+// Newest modification time of the source images, a cache older than them is stale
+int64_t Frame_Cache::get_source_time() {
+   int64_t newest = 0;
+   for (int i=0; i<frame_count; ++i) {
+      std::error_code error;
+      auto time = std::filesystem::last_write_time(directory + std::to_string(i) + ".png", error);
+      if (!error) newest = std::max(newest, static_cast<int64_t>(time.time_since_epoch().count()));
+   }
+   return newest;
+}
+
+/* Cache file layout
+ * FRAMES=<frame_count> LINES=<lines per frame> SOURCE=<newest source image time>
+ * <line>
+ * ...
+*/
+bool Frame_Cache::load(int width, int height, frames& loaded) {
+   std::ifstream infile(get_cache_path(width, height));
+   std::string header;
+   if (!std::getline(infile, header)) return false;
+   int num_frames = 0, num_lines = 0;
+   int64_t source_time = 0;
+   if (std::sscanf(header.c_str(), "FRAMES=%d LINES=%d SOURCE=%ld", &num_frames, &num_lines, &source_time) != 3) return false;
+   if (num_frames <= 0 || num_lines <= 0 || source_time != get_source_time()) return false;
+
+   loaded.assign(num_frames, std::vector<std::string>(num_lines));
+   for (auto& frame : loaded) {
+      for (auto& line : frame) {
+         if (!std::getline(infile, line)) return false;
+      }
+   }
+   return true;
+}
+
+void Frame_Cache::save(int width, int height, const frames& generated) {
+   if (generated.empty()) return;
+   std::error_code error;
+   std::filesystem::create_directories(directory + "cache/", error);
+   std::ofstream outfile(get_cache_path(width, height), std::ios::out | std::ios::trunc);
+   if (!outfile.is_open()) return;
+
+   outfile << "FRAMES=" << generated.size() << " LINES=" << generated[0].size() << " SOURCE=" << get_source_time() << "\n";
+   for (const auto& frame : generated) {
+      for (const auto& line : frame) outfile << line << "\n";
+   }
+}
+
+// Start loading or generating the frames of a size, without waiting for them
+void Frame_Cache::prepare(int width, int height) {
+   std::lock_guard<std::mutex> lock(mutex);
+   auto key = std::make_pair(width, height);
+   if (sizes.count(key)) return;
+   sizes[key] = std::async(std::launch::async, [this, width, height] {
+      frames cached;
+      if (load(width, height, cached)) return cached;
+      frames generated = generate_all_frames(width, height, directory, frame_count);
+      save(width, height, generated);
+      return generated;
+   }).share();
+}
+
+// Frame index (wrapping) of a size, empty while its frames are being generated
+std::vector<std::string> Frame_Cache::get_frame(int width, int height, int index) {
+   prepare(width, height);
+   std::lock_guard<std::mutex> lock(mutex);
+   const std::shared_future<frames>& future = sizes[std::make_pair(width, height)];
+   if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return {};
+   const frames& ready = future.get();
+   if (ready.empty()) return {};
+   return ready[index % ready.size()];
+}
@@ -0,0 +1,92 @@
+#include "controller.hpp"
+
+using namespace Autotuna;
+
+// Same limits as the High/Limit status of the cos performance summary
+bool Autotuna::needs_more_ways(const cos_observation& observation, uint64_t threshold) {
+   return observation.occupancy >= 0.85 || observation.misses >= threshold;
+}
+
+// Demand the cos is about to reach: the forecast ramp, if above what it shows now
+cos_observation Autotuna::anticipate(const cos_observation& observation) {
+   cos_observation anticipated = observation;
+   if (observation.forecast_misses >= 0) anticipated.misses = std::max(observation.misses, observation.forecast_misses);
+   if (observation.forecast_occupancy >= 0) anticipated.occupancy = std::max(observation.occupancy, observation.forecast_occupancy);
+   return anticipated;
+}
+
+/* Pick at most one way to move per decision
+ * receiver: the cos in High/Limit status with the highest priority weighted misses
+ * donor: a cos above its floor, not in High/Limit status, with the lowest priority weighted misses
+ * The move only happens if the receiver's weighted misses exceed the donor's by the hysteresis
+ * factor and neither cos changed within the minimum dwell time, so allocations don't oscillate.
+*/
+way_move Autotuna::decide_way_move(const std::vector<cos_observation>& observations, int64_t now, int64_t min_dwell, double hysteresis, uint64_t threshold) {
+   way_move move = {false, 0, 0};
+   const cos_observation* receiver = nullptr;
+   const cos_observation* donor = nullptr;
+
+   for (const cos_observation& observation : observations) {
+      if (now - observation.last_change < min_dwell) continue;
+      double pressure = observation.weight * observation.misses;
+      if (needs_more_ways(observation, threshold)) {
+         if (receiver == nullptr || pressure > receiver->weight * receiver->misses) receiver = &observation;
+      }
+      else if (observation.num_ways > observation.floor_ways) {
+         if (donor == nullptr || pressure < donor->weight * donor->misses) donor = &observation;
+      }
+   }
+
+   if (receiver == nullptr || donor == nullptr) return move;
+   if (receiver->weight * receiver->misses <= (1.0 + hysteresis) * donor->weight * donor->misses) return move;
+
+   move = {true, donor->cos, receiver->cos};
+   return move;
+}
+
+// Over-provisioned: sustained low occupancy of its ways, and losing one would barely raise its misses
+bool Autotuna::is_idle(const cos_observation& observation, double max_occupancy, double max_sensitivity) {
+   return observation.sustained_occupancy >= 0 && observation.sustained_occupancy < max_occupancy && observation.sensitivity <= max_sensitivity;
+}
+
+/* Reclaim one idle way per decision
+ * donor: the idle cos above its floor with the lowest sustained occupancy
+ * receiver: the cos in High/Limit status with the highest priority weighted misses
+ * The way is lent, not given: decide_loan_return hands it back once the donor needs it.
+*/
+way_move Autotuna::decide_reclaim(const std::vector<cos_observation>& observations, int64_t now, int64_t min_dwell, double max_occupancy, double max_sensitivity, uint64_t threshold) {
+   way_move move = {false, 0, 0};
+   const cos_observation* receiver = nullptr;
+   const cos_observation* donor = nullptr;
+
+   for (const cos_observation& observation : observations) {
+      if (now - observation.last_change < min_dwell) continue;
+      if (needs_more_ways(observation, threshold)) {
+         if (receiver == nullptr || observation.weight * observation.misses > receiver->weight * receiver->misses) receiver = &observation;
+      }
+      else if (observation.num_ways > observation.floor_ways && is_idle(observation, max_occupancy, max_sensitivity)) {
+         if (donor == nullptr || observation.sustained_occupancy < donor->sustained_occupancy) donor = &observation;
+      }
+   }
+   if (receiver == nullptr || donor == nullptr) return move;
+
+   move = {true, donor->cos, receiver->cos};
+   return move;
+}
+
+// Return one lent way to a donor whose occupancy climbed back, regardless of dwell time
+way_move Autotuna::decide_loan_return(const std::vector<cos_observation>& observations, const way_loans& loans, double return_occupancy) {
+   way_move move = {false, 0, 0};
+   for (const cos_observation& observation : observations) {
+      auto lent = loans.find(observation.cos);
+      if (lent == loans.end() || observation.occupancy < return_occupancy) continue;
+      for (const auto&[receiver, num_ways] : lent->second) {
+         if (num_ways <= 0) continue;
+         auto borrower = std::find_if(observations.begin(), observations.end(), [&](const cos_observation& o) { return o.cos == receiver; });
+         if (borrower == observations.end() || borrower->num_ways <= 1) continue;
+         move = {true, receiver, observation.cos};
+         return move;
+      }
+   }
+   return move;
+}
@@ -0,0 +1,71 @@
+#include "cpu_set.hpp"
+
+Cpu_Set::Cpu_Set(const std::set<int>& cpus) {
+   for (const int& cpu : cpus) insert(cpu);
+}
+
+Cpu_Set Cpu_Set::range(int first, int last) {
+   Cpu_Set cpus;
+   if (first > last) std::swap(first, last);
+   for (int cpu=std::max(0, first); cpu<=last; ++cpu) cpus.insert(cpu);
+   return cpus;
+}
+
+// The cpu and the other hardware threads of its core
+Cpu_Set Cpu_Set::smt_siblings(const Topology::cpu_topology& topology, int cpu) {
+   auto thread = topology.cpus.find(cpu);
+   if (thread == topology.cpus.end()) return Cpu_Set({cpu});
+   return Cpu_Set(thread->second.siblings);
+}
+
+Cpu_Set Cpu_Set::numa_node(const Topology::cpu_topology& topology, int cpu) {
+   auto thread = topology.cpus.find(cpu);
+   if (thread == topology.cpus.end() || !topology.numa_nodes.count(thread->second.numa_node)) return Cpu_Set({cpu});
+   return Cpu_Set(topology.numa_nodes.at(thread->second.numa_node));
+}
+
+Cpu_Set Cpu_Set::l3_domain(const Topology::cpu_topology& topology, int cpu) {
+   auto thread = topology.cpus.find(cpu);
+   if (thread == topology.cpus.end() || !topology.l3_domains.count(thread->second.l3_domain)) return Cpu_Set({cpu});
+   return Cpu_Set(topology.l3_domains.at(thread->second.l3_domain));
+}
+
+void Cpu_Set::insert(int cpu) {
+   if (cpu < 0) return;
+   size_t word = cpu / 64;
+   if (word >= words.size()) words.resize(word + 1, 0);
+   words[word] |= uint64_t(1) << (cpu % 64);
+}
+
+void Cpu_Set::erase(int cpu) {
+   if (cpu < 0 || static_cast<size_t>(cpu / 64) >= words.size()) return;
+   words[cpu / 64] &= ~(uint64_t(1) << (cpu % 64));
+}
+
+bool Cpu_Set::contains(int cpu) const {
+   if (cpu < 0 || static_cast<size_t>(cpu / 64) >= words.size()) return false;
+   return (words[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+size_t Cpu_Set::count() const {
+   size_t total = 0;
+   for (const uint64_t& word : words) total += __builtin_popcountll(word);
+   return total;
+}
+
+bool Cpu_Set::empty() const {
+   for (const uint64_t& word : words) {
+      if (word != 0) return false;
+   }
+   return true;
+}
+
+std::vector<int> Cpu_Set::to_vector() const {
+   std::vector<int> cpus;
+   for (size_t i=0; i<words.size(); ++i) {
+      for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+         cpus.push_back(static_cast<int>(i * 64 + __builtin_ctzll(word)));
+      }
+   }
+   return cpus;
+}
@@ -0,0 +1,234 @@
+#include "experiment.hpp"
+
+using namespace Autotuna;
+
+void running_stats::add(double value) {
+   ++count;
+   double delta = value - mean;
+   mean += delta / count;
+   m2 += delta * (value - mean);
+}
+
+double running_stats::variance() const {
+   return count < 2 ? 0.0 : m2 / (count - 1);
+}
+
+// Normal quantile, Acklam's rational approximation (relative error < 1.2e-9)
+static double normal_quantile(double p) {
+   static const double a[] = {-39.69683028665376, 220.9460984245205, -275.9285104469687, 138.3577518672690, -30.66479806614716, 2.506628277459239};
+   static const double b[] = {-54.47609879822406, 161.5858368580409, -155.6989798598866, 66.80131188771972, -13.28068155288572};
+   static const double c[] = {-0.007784894002430293, -0.3223964580411365, -2.400758277161838, -2.549732539343734, 4.374664141464968, 2.938163982698783};
+   static const double d[] = {0.007784695709041462, 0.3224671290700398, 2.445134137142996, 3.754408661907416};
+   const double p_low = 0.02425;
+
+   if (p <= 0) return -std::numeric_limits<double>::infinity();
+   if (p >= 1) return std::numeric_limits<double>::infinity();
+   if (p < p_low || p > 1 - p_low) {
+      double q = std::sqrt(-2 * std::log(p < p_low ? p : 1 - p));
+      double z = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+      return p < p_low ? z : -z;
+   }
+   double q = p - 0.5;
+   double r = q * q;
+   return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+// Student's t cdf for integer df, closed form series of Abramowitz & Stegun 26.7.3/26.7.4
+static double t_cdf(double t, int df) {
+   double theta = std::atan(std::abs(t) / std::sqrt(df));
+   double cos2 = std::cos(theta) * std::cos(theta);
+   double term = 1.0;
+   double sum = df % 2 == 0 ? 1.0 : 0.0;
+   for (int k = df % 2 == 0 ? 2 : 3; k < df; k += 2) {
+      term *= cos2 * (k - 1) / k;
+      sum += term;
+   }
+   // P(|T| < t)
+   double inside = df % 2 == 0 ? std::sin(theta) * sum
+                               : 2 / M_PI * (theta + (df > 1 ? std::sin(theta) * std::cos(theta) * (1.0 + sum) : 0.0));
+   return t >= 0 ? 0.5 + inside / 2 : 0.5 - inside / 2;
+}
+
+// Exact quantile for integer df by bisection of the cdf
+static double t_quantile_exact(double p, int df) {
+   double low = 0.0;
+   double high = 1.0;
+   double target = p >= 0.5 ? p : 1 - p;
+   while (t_cdf(high, df) < target && high < 1e12) high *= 2;
+   for (int i=0; i<100; ++i) {
+      double mid = (low + high) / 2;
+      if (t_cdf(mid, df) < target) low = mid;
+      else high = mid;
+   }
+   return p >= 0.5 ? high : -high;
+}
+
+/* Student's t quantile: exact below small_df, whose tails the Cornish-Fisher expansion around the normal
+ * quantile underestimates (9.7 instead of 12.71 at df 1, p 0.975); fractional Welch df interpolate in 1/df
+*/
+double Autotuna::t_quantile(double p, double df) {
+   const int small_df = 10;
+   double z = normal_quantile(p);
+   if (df <= 0 || std::isinf(df)) return z;
+   if (df < small_df) {
+      int lower = std::max(1, static_cast<int>(df));
+      double t_lower = t_quantile_exact(p, lower);
+      if (df <= lower) return t_lower;
+      double t_upper = t_quantile_exact(p, lower + 1);
+      double fraction = (1.0 / lower - 1.0 / df) / (1.0 / lower - 1.0 / (lower + 1));
+      return t_lower + fraction * (t_upper - t_lower);
+   }
+   double z3 = z * z * z;
+   double z5 = z3 * z * z;
+   double z7 = z5 * z * z;
+   return z + (z3 + z) / (4 * df)
+            + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df)
+            + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * df * df * df);
+}
+
+effect_estimate Autotuna::welch_effect(const running_stats& a, const running_stats& b, double confidence) {
+   effect_estimate effect = {a.count, b.count, a.mean, b.mean, b.mean - a.mean, 0.0, 0.0, 0.0, 0.0, false};
+   if (a.mean != 0) effect.relative = effect.difference / a.mean;
+   if (a.count < 2 || b.count < 2) {
+      effect.ci_low = -std::numeric_limits<double>::infinity();
+      effect.ci_high = std::numeric_limits<double>::infinity();
+      return effect;
+   }
+
+   double var_a = a.variance() / a.count;
+   double var_b = b.variance() / b.count;
+   double standard_error = std::sqrt(var_a + var_b);
+   // Welch-Satterthwaite degrees of freedom
+   double df = standard_error > 0 ? std::pow(var_a + var_b, 2) / (var_a * var_a / (a.count - 1) + var_b * var_b / (b.count - 1)) : a.count + b.count - 2;
+   double margin = t_quantile(0.5 + confidence / 2, df) * standard_error;
+   effect.ci_low = effect.difference - margin;
+   effect.ci_high = effect.difference + margin;
+
+   double pooled = std::sqrt(((a.count - 1) * a.variance() + (b.count - 1) * b.variance()) / (a.count + b.count - 2));
+   if (pooled > 0) effect.cohens_d = effect.difference / pooled;
+   effect.significant = effect.ci_low > 0 || effect.ci_high < 0;
+   return effect;
+}
+
+Experiment::Experiment() :
+   duration(0),
+   min_interval(0),
+   max_interval(0),
+   settle(0),
+   elapsed(0),
+   arm(0),
+   interval_length(0),
+   interval_elapsed(0),
+   pair_started(false),
+   running(false),
+   interval_count(0)
+{}
+
+int Experiment::next_interval_length() {
+   std::uniform_int_distribution<int> length(min_interval, max_interval);
+   return length(rng);
+}
+
+// Returns the arm to apply first
+int Experiment::start(int _duration, int _min_interval, int _max_interval, int _settle, unsigned seed) {
+   settle = std::max(0, _settle);
+   min_interval = std::max(settle + 2, _min_interval);
+   max_interval = std::max(min_interval, _max_interval);
+   duration = std::max(2 * min_interval, _duration);
+   rng.seed(seed);
+   stats[0].clear();
+   stats[1].clear();
+   interval_sums.clear();
+   interval_count = 0;
+   elapsed = 0;
+   interval_elapsed = 0;
+   interval_length = next_interval_length();
+   arm = std::uniform_int_distribution<int>(0, 1)(rng);
+   pair_started = true;
+   running = true;
+   return arm;
+}
+
+// One sample per cos and metric, returns the arm to run next: unchanged, switched, or -1 once finished
+int Experiment::add_sample(const std::map<unsigned, std::map<std::string, double>>& sample) {
+   if (!running) return -1;
+   ++elapsed;
+   if (++interval_elapsed > settle) {
+      for (const auto&[cos, metrics] : sample) {
+         for (const auto&[metric, value] : metrics) interval_sums[cos][metric] += value;
+      }
+      ++interval_count;
+   }
+   if (interval_elapsed < interval_length) return arm;
+
+   // close the interval: its mean is one observation of the arm
+   if (interval_count > 0) {
+      for (const auto&[cos, metrics] : interval_sums) {
+         for (const auto&[metric, sum] : metrics) stats[arm][cos][metric].add(sum / interval_count);
+      }
+   }
+   interval_sums.clear();
+   interval_count = 0;
+   interval_elapsed = 0;
+   interval_length = next_interval_length();
+
+   if (pair_started) {
+      // play the other arm to complete the pair
+      arm = 1 - arm;
+      pair_started = false;
+      return arm;
+   }
+   if (elapsed >= duration) {
+      running = false;
+      return -1;
+   }
+   arm = std::uniform_int_distribution<int>(0, 1)(rng);
+   pair_started = true;
+   return arm;
+}
+
+bool Experiment::is_running() {
+   return running;
+}
+
+int Experiment::get_arm() {
+   return arm;
+}
+
+int Experiment::get_elapsed() {
+   return elapsed;
+}
+
+int Experiment::get_duration() {
+   return duration;
+}
+
+std::vector<experiment_row> Experiment::report(double confidence) {
+   std::vector<experiment_row> rows;
+   for (const auto&[cos, metrics] : stats[0]) {
+      auto cos_b = stats[1].find(cos);
+      if (cos_b == stats[1].end()) continue;
+      for (const auto&[metric, stats_a] : metrics) {
+         auto stats_b = cos_b->second.find(metric);
+         if (stats_b == cos_b->second.end()) continue;
+         rows.push_back({cos, metric, welch_effect(stats_a, stats_b->second, confidence)});
+      }
+   }
+   return rows;
+}
+
+void Experiment::write_report(const std::string& file_path, const std::string& config_a, const std::string& config_b, double confidence) {
+   std::ofstream outfile(file_path, std::ios::out | std::ios::trunc);
+   if (!outfile.is_open()) return;
+
+   outfile << "# A/B experiment: A=" << config_a << " B=" << config_b << ", " << elapsed << "s, "
+           << static_cast<int>(confidence * 100) << "% confidence intervals of B - A over interval means\n";
+   outfile << "# cos metric n_a n_b mean_a mean_b difference ci_low ci_high relative cohens_d significant\n";
+   outfile << std::fixed << std::setprecision(4);
+   for (const experiment_row& row : report(confidence)) {
+      const effect_estimate& e = row.effect;
+      outfile << row.cos << " " << row.metric << " " << e.n_a << " " << e.n_b << " " << e.mean_a << " " << e.mean_b << " "
+              << e.difference << " " << e.ci_low << " " << e.ci_high << " " << e.relative << " " << e.cohens_d << " "
+              << (e.significant ? "yes" : "no") << "\n";
+   }
+}
@@ -0,0 +1,189 @@
+#include "forecaster.hpp"
+
+using namespace Autotuna;
+
+/* Rollup file layout
+ * BUCKET=<seconds> SEASON=<buckets>
+ * <cos> <bucket_start> <misses_average> <llc_average>
+ * ...
+*/
+
+void holt_winters::update(double value, int64_t index, double alpha, double beta, double gamma, double phi) {
+   size_t slot = index % season.size();
+   // first season: the level is its running mean, each slot keeps its raw value
+   if (count < season.size()) {
+      if (count == 0) std::fill(season.begin(), season.end(), NAN);
+      season[slot] = value;
+      level += (value - level) / (count + 1);
+      last_index = index;
+      if (++count < season.size()) return;
+      // seasonal components relative to the mean, slots not seen (not monitoring) have none
+      for (double& seasonal : season) seasonal = std::isnan(seasonal) ? 0.0 : seasonal - level;
+      return;
+   }
+   // buckets without samples only carry the damped trend forward
+   for (int64_t skipped = last_index + 1; skipped < index; ++skipped) {
+      level += phi * trend;
+      trend *= phi;
+   }
+   double seasonal = season[slot];
+   double previous_level = level;
+   level = alpha * (value - seasonal) + (1 - alpha) * (level + phi * trend);
+   trend = beta * (level - previous_level) + (1 - beta) * phi * trend;
+   season[slot] = gamma * (value - level) + (1 - gamma) * seasonal;
+   last_index = index;
+   ++count;
+}
+
+double holt_winters::forecast(int64_t index, double phi) const {
+   int64_t horizon = std::max(static_cast<int64_t>(0), index - last_index);
+   double damped = 0.0;
+   double factor = 1.0;
+   for (int64_t h=0; h<horizon; ++h) {
+      factor *= phi;
+      damped += factor;
+   }
+   double seasonal = count >= season.size() ? season[index % season.size()] : 0.0;
+   return std::max(0.0, level + damped * trend + seasonal);
+}
+
+Forecaster::Forecaster(int64_t _bucket_seconds, int64_t _season_seconds, double _alpha, double _beta, double _gamma, double _phi) {
+   configure(_bucket_seconds, _season_seconds, _alpha, _beta, _gamma, _phi);
+}
+
+void Forecaster::configure(int64_t _bucket_seconds, int64_t _season_seconds, double _alpha, double _beta, double _gamma, double _phi) {
+   bucket_seconds = std::max(static_cast<int64_t>(1), _bucket_seconds);
+   season_length = std::max(static_cast<int64_t>(2), _season_seconds / bucket_seconds);
+   alpha = std::clamp(_alpha, 0.0, 1.0);
+   beta = std::clamp(_beta, 0.0, 1.0);
+   gamma = std::clamp(_gamma, 0.0, 1.0);
+   phi = std::clamp(_phi, 0.0, 1.0);
+   states.clear();
+}
+
+bool Forecaster::is_seasonal(const cos_state& state) const {
+   return state.misses_model.count >= season_length;
+}
+
+void Forecaster::close_bucket(cos_state& state, const rollup& bucket) {
+   rollup closed = bucket;
+   int64_t index = bucket.start / bucket_seconds;
+   // forecast as it stood before the bucket's samples came in
+   closed.has_forecast = state.misses_model.count >= 2;
+   closed.forecast_misses = closed.has_forecast ? state.misses_model.forecast(index, phi) : 0.0;
+   closed.forecast_llc = closed.has_forecast ? state.llc_model.forecast(index, phi) : 0.0;
+
+   if (state.misses_model.season.empty()) state.misses_model.season.assign(season_length, 0.0);
+   if (state.llc_model.season.empty()) state.llc_model.season.assign(season_length, 0.0);
+   state.misses_model.update(bucket.misses, index, alpha, beta, gamma, phi);
+   state.llc_model.update(bucket.llc, index, alpha, beta, gamma, phi);
+
+   state.rollups.push_back(closed);
+   while (state.rollups.size() > 7 * season_length) state.rollups.pop_front();
+}
+
+// Returns true when the sample closed a bucket, i.e. the rollups changed
+bool Forecaster::add_sample(unsigned cos, int64_t timestamp, double misses, double llc) {
+   cos_state& state = states[cos];
+   int64_t start = timestamp - timestamp % bucket_seconds;
+   bool closed = false;
+   if (state.open_start != start) {
+      if (state.open_count > 0 && start > state.open_start) {
+         close_bucket(state, {state.open_start, state.misses_sum / state.open_count, state.llc_sum / state.open_count, false, 0.0, 0.0});
+         closed = true;
+      }
+      state.open_start = start;
+      state.misses_sum = 0.0;
+      state.llc_sum = 0.0;
+      state.open_count = 0;
+   }
+   state.misses_sum += misses;
+   state.llc_sum += llc;
+   ++state.open_count;
+   return closed;
+}
+
+// Highest forecast demand over the buckets overlapping [from, to], invalid before a full season was seen
+demand_forecast Forecaster::forecast(unsigned cos, int64_t from, int64_t to) const {
+   demand_forecast prediction = {false, 0.0, 0.0};
+   auto state = states.find(cos);
+   if (state == states.end() || !is_seasonal(state->second)) return prediction;
+
+   prediction.valid = true;
+   for (int64_t index = from / bucket_seconds; index <= to / bucket_seconds; ++index) {
+      prediction.misses = std::max(prediction.misses, state->second.misses_model.forecast(index, phi));
+      prediction.llc = std::max(prediction.llc, state->second.llc_model.forecast(index, phi));
+   }
+   return prediction;
+}
+
+// Forecast that was (or is) in effect for the bucket holding timestamp
+demand_forecast Forecaster::forecast_at(unsigned cos, int64_t timestamp) const {
+   demand_forecast prediction = {false, 0.0, 0.0};
+   auto state = states.find(cos);
+   if (state == states.end() || state->second.misses_model.count == 0) return prediction;
+
+   int64_t start = timestamp - timestamp % bucket_seconds;
+   if (start / bucket_seconds > state->second.misses_model.last_index) {
+      if (state->second.misses_model.count < 2) return prediction;
+      return {true, state->second.misses_model.forecast(start / bucket_seconds, phi), state->second.llc_model.forecast(start / bucket_seconds, phi)};
+   }
+   const std::deque<rollup>& rollups = state->second.rollups;
+   auto bucket = std::lower_bound(rollups.begin(), rollups.end(), start, [](const rollup& r, int64_t value) { return r.start < value; });
+   if (bucket == rollups.end() || bucket->start != start || !bucket->has_forecast) return prediction;
+   return {true, bucket->forecast_misses, bucket->forecast_llc};
+}
+
+// Relative absolute error of the misses forecasts over the last season, -1 without forecasts
+double Forecaster::get_error(unsigned cos) const {
+   auto state = states.find(cos);
+   if (state == states.end()) return -1;
+   double error = 0.0, actual = 0.0;
+   const std::deque<rollup>& rollups = state->second.rollups;
+   size_t first = rollups.size() > season_length ? rollups.size() - season_length : 0;
+   for (size_t i=first; i<rollups.size(); ++i) {
+      if (!rollups[i].has_forecast) continue;
+      error += std::abs(rollups[i].forecast_misses - rollups[i].misses);
+      actual += rollups[i].misses;
+   }
+   return actual > 0 ? error / actual : -1;
+}
+
+// Different workload, its history doesn't predict anything
+void Forecaster::clear(unsigned cos) {
+   states.erase(cos);
+}
+
+void Forecaster::load(const std::string& file_path, int64_t now) {
+   std::ifstream infile(file_path);
+   std::string line;
+   std::ostringstream header;
+   header << "BUCKET=" << bucket_seconds << " SEASON=" << season_length;
+   // rollups of a different bucket length or season don't fit the models
+   if (!std::getline(infile, line) || line != header.str()) return;
+
+   states.clear();
+   int64_t oldest = now - static_cast<int64_t>(7 * season_length) * bucket_seconds;
+   while (std::getline(infile, line)) {
+      std::istringstream iss(line);
+      unsigned cos;
+      rollup bucket = {0, 0.0, 0.0, false, 0.0, 0.0};
+      if (!(iss >> cos >> bucket.start >> bucket.misses >> bucket.llc)) continue;
+      if (bucket.start < oldest) continue; // expired
+      cos_state& state = states[cos];
+      if (!state.rollups.empty() && bucket.start <= state.rollups.back().start) continue;
+      close_bucket(state, bucket);
+   }
+}
+
+void Forecaster::save(const std::string& file_path) const {
+   std::ofstream outfile(file_path, std::ios::out | std::ios::trunc);
+   if (!outfile.is_open()) return;
+
+   outfile << "BUCKET=" << bucket_seconds << " SEASON=" << season_length << "\n";
+   for (const auto&[cos, state] : states) {
+      for (const rollup& bucket : state.rollups) {
+         outfile << cos << " " << bucket.start << " " << bucket.misses << " " << bucket.llc << "\n";
+      }
+   }
+}
@@ -7,7 +7,10 @@ Graph::Graph(const std::string& _title, const std::string& _data_type):
    data_type(_data_type),
    bar_width(3),
    bar_separator_width(1),
-   bar_datum_width(bar_width + bar_separator_width)
+   bar_datum_width(bar_width + bar_separator_width),
+   datum_width(15),
+   min_column_width(2),
+   canvas_width(Terminal::Size().dimx)
 {
 }
 
@@ -69,7 +72,7 @@ GraphFunction Graph::bar_graph_function(const std::vector<uint64_t>& data, doubl
 }
 
 // Bar graph
-Element Graph::get_graph(const std::vector<uint64_t> data) {
+Element Graph::get_graph(const std::vector<uint64_t>& data) {
    if (data.empty()) {
       return vbox({
             text(title) | hcenter,
@@ -89,53 +92,46 @@ Element Graph::get_graph(const std::vector<uint64_t> data) {
         });
 }
 
-Canvas Graph::line_plot_function(const std::vector<std::vector<uint64_t>> mon_data_vec, const std::vector<unsigned> index_vec, uint64_t max, uint64_t min) {
-   size_t j;
-   int y1, y2, x1, x2;
-   std::vector<uint64_t> data;
+// Plot width in columns and the samples they cover; the width is the canvas' from the previous frame
+plot_view Graph::get_view(const plot_window& window) {
+   size_t max_columns = std::max(1, canvas_width / datum_width);
+   if (window.span == 0) return {max_columns, window.offset, max_columns};
+   return {window.span, window.offset, std::min(window.span, static_cast<size_t>(std::max(1, canvas_width / min_column_width)))};
+}
 
-   int datum_width = 15;
+void Graph::draw_line_plot(Canvas& canvas, const std::vector<plot_series>& series_vec, double max_scale, size_t num_columns) {
+   canvas_width = canvas.width();
+   if (max_scale == 0 || num_columns == 0) return;
    int label_width = 20;
+   int canvas_height = canvas.height() - 4; // room for the labels
 
-   int canvas_height = Terminal::Size().dimy;
-   int canvas_width = Terminal::Size().dimx;
-   Canvas canvas = Canvas(canvas_width, canvas_height + canvas_height * 0.05);
-
-   auto scale = [&](uint64_t value) -> double{
-      double max_scale = get_y_scale(max);
-      return canvas_height - ((value/max_scale) * canvas_height);
+   auto x = [&](size_t column) -> int {
+      return column * canvas.width() / num_columns;
+   };
+   auto y = [&](uint64_t value) -> int {
+      return canvas_height - ((value / max_scale) * canvas_height);
    };
 
-   // line for each cos
-   std::vector<double> label_position;
-   for (size_t i=0; i<mon_data_vec.size(); ++i) {
-      x1=0;
-      x2=datum_width;
-      data = mon_data_vec[i];
-      int data_width = data.size() * datum_width;
-      j = canvas_width <= data_width ? (data_width - canvas_width) / datum_width : 0;
-      for (j; j<data.size(); ++j) {
-         y1 = scale(data[j-1]);
-         y2 = scale(data[j]);
-         canvas.DrawPointLine(x1, y1, x2, y2, Color::White);
-         x1 += datum_width;
-         x2 += datum_width;
+   // line for each cos, with a vertical min/max stroke for columns holding several samples
+   for (size_t i=0; i<series_vec.size(); ++i) {
+      const plot_series& series = series_vec[i];
+      for (const size_t& marker : series.markers) { // phase boundaries
+         canvas.DrawPointLine(x(marker), 0, x(marker), canvas_height, Color::Yellow);
       }
-      label_position.push_back(data[data.size()-2]);
-   }
-   // label
-   for (size_t i=0; i<label_position.size(); ++i) {
-      std::string label = "Cos " + std::to_string(index_vec[i]);
-      canvas.DrawText(i * label_width, scale(label_position[i]), label);
+      for (size_t column=0; column<series.columns.size(); ++column) {
+         const series_span& span = series.columns[column];
+         if (series.forecast[column] != Series_Index::no_value) canvas.DrawPoint(x(column), y(series.forecast[column]), true, Color::GrayDark);
+         if (span.min != span.max) canvas.DrawPointLine(x(column), y(span.min), x(column), y(span.max), Color::GrayLight);
+         if (column > 0) canvas.DrawPointLine(x(column-1), y(series.columns[column-1].last), x(column), y(span.last), Color::White);
+      }
+      if (!series.columns.empty()) canvas.DrawText(i * label_width, y(series.columns.back().last), "Cos " + std::to_string(series.cos));
    }
-
-   return canvas;
 }
 
 // Line Plot
-Element Graph::get_graph(const std::vector<std::vector<uint64_t>> mon_data_vec, std::vector<unsigned> index_vec) {
-   bool any_empty = std::any_of(mon_data_vec.begin(), mon_data_vec.end(), std::mem_fn(&std::vector<uint64_t>::empty));
-   if (any_empty) {
+Element Graph::get_graph(const std::vector<plot_series>& series_vec, const plot_view& view) {
+   bool any_empty = std::any_of(series_vec.begin(), series_vec.end(), [](const plot_series& series) { return series.columns.empty(); });
+   if (series_vec.empty() || any_empty) {
       return vbox({
             text(title) | hcenter,
             filler(),
@@ -143,28 +139,29 @@ Element Graph::get_graph(const std::vector<std::vector<uint64_t>> mon_data_vec,
             });
    }
 
-   uint64_t element;
-   int start_index = mon_data_vec[0].size() >= 12 ? mon_data_vec[0].size() - 12 : 0;
-   uint64_t max = mon_data_vec[0][start_index];
-   uint64_t min = mon_data_vec[0][start_index];
-   for (auto row : mon_data_vec) {
-      for (size_t i=start_index; i<row.size(); ++i) {
-         element = row[i];
-         max = element > max? element : max;
-         min = element < min? element : min;
+   uint64_t max = 0;
+   for (const plot_series& series : series_vec) {
+      for (size_t column=0; column<series.columns.size(); ++column) {
+         max = std::max(max, series.columns[column].max);
+         if (series.forecast[column] != Series_Index::no_value) max = std::max(max, series.forecast[column]);
       }
    }
-
    double scale = get_y_scale(max);
 
+   // zoomed or panned views name their range
+   std::string range;
+   if (view.span != get_view({}).span || view.offset != 0) {
+      range = " (" + Misc::format_duration(view.span) + (view.offset == 0 ? "" : ", " + Misc::format_duration(view.offset) + " ago") + ")";
+   }
+
    return vbox({
-         text(title)
+         text(title + range)
          | hcenter,
          hbox({
                get_y_labels(scale),
                separatorEmpty(),
                vbox({
-                  canvas(std::move(line_plot_function(mon_data_vec, index_vec, max, min))) | yflex_grow
+                  canvas([this, series_vec, scale, view](Canvas& c) { draw_line_plot(c, series_vec, scale, view.columns); }) | yflex_grow
                   })
                })
          })
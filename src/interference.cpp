@@ -0,0 +1,66 @@
+#include "interference.hpp"
+
+using namespace Autotuna;
+
+// Pearson correlation of the first differences, 0 when either series is flat
+double Autotuna::correlation(const std::vector<double>& x, const std::vector<double>& y) {
+   size_t n = std::min(x.size(), y.size());
+   if (n < 3) return 0.0;
+
+   std::vector<double> dx(n - 1), dy(n - 1);
+   for (size_t i=1; i<n; ++i) {
+      dx[i-1] = x[x.size() - n + i] - x[x.size() - n + i - 1];
+      dy[i-1] = y[y.size() - n + i] - y[y.size() - n + i - 1];
+   }
+   double mean_x = 0, mean_y = 0;
+   for (size_t i=0; i<dx.size(); ++i) {
+      mean_x += dx[i];
+      mean_y += dy[i];
+   }
+   mean_x /= dx.size();
+   mean_y /= dy.size();
+
+   double cov = 0, var_x = 0, var_y = 0;
+   for (size_t i=0; i<dx.size(); ++i) {
+      cov += (dx[i] - mean_x) * (dy[i] - mean_y);
+      var_x += (dx[i] - mean_x) * (dx[i] - mean_x);
+      var_y += (dy[i] - mean_y) * (dy[i] - mean_y);
+   }
+   if (var_x <= 0 || var_y <= 0) return 0.0;
+   return cov / std::sqrt(var_x * var_y);
+}
+
+// Fraction of the victim's ways the suspect also uses
+double Autotuna::mask_overlap(const Way_Mask& victim, const Way_Mask& suspect) {
+   if (victim.empty()) return 0.0;
+   return static_cast<double>((victim & suspect).count()) / victim.count();
+}
+
+/* Who hurts whom
+ * A suspect is blamed for a victim's miss spikes when its occupancy or memory bandwidth rises
+ * at the same time: the score is the stronger positive correlation of their changes over the
+ * window, weighted by how much of the victim's ways the suspect shares. Disjoint masks keep
+ * a tenth of the weight, bandwidth and DDIO interference cross way partitions.
+*/
+interference_matrix Autotuna::attribute_interference(const std::map<unsigned, cos_activity>& activity) {
+   interference_matrix matrix;
+   for (const auto&[victim, victim_activity] : activity) {
+      for (const auto&[suspect, suspect_activity] : activity) {
+         if (suspect == victim) continue;
+         double occupancy_corr = correlation(victim_activity.misses, suspect_activity.llc);
+         double bandwidth_corr = correlation(victim_activity.misses, suspect_activity.bandwidth);
+         double weight = 0.1 + 0.9 * mask_overlap(victim_activity.bitmask, suspect_activity.bitmask);
+         matrix[victim][suspect] = weight * std::max({0.0, occupancy_corr, bandwidth_corr});
+      }
+   }
+   return matrix;
+}
+
+std::vector<suspect> Autotuna::rank_suspects(const interference_matrix& matrix, unsigned victim) {
+   std::vector<suspect> suspects;
+   auto row = matrix.find(victim);
+   if (row == matrix.end()) return suspects;
+   for (const auto&[cos, score] : row->second) suspects.push_back({cos, score});
+   std::sort(suspects.begin(), suspects.end(), [](const suspect& a, const suspect& b) { return a.score > b.score; });
+   return suspects;
+}
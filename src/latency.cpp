@@ -0,0 +1,75 @@
+#include "latency.hpp"
+
+using namespace Latency;
+
+// Values below 16 ns get a bucket each, then 8 buckets per power of two
+unsigned Histogram::get_bucket(uint64_t ns) {
+   if (ns < 2 * sub_buckets) return static_cast<unsigned>(ns);
+   unsigned msb = 63 - __builtin_clzll(ns);
+   unsigned sub = (ns >> (msb - 3)) & (sub_buckets - 1);
+   return 2 * sub_buckets + (msb - 4) * sub_buckets + sub;
+}
+
+// Middle of the bucket's range
+uint64_t Histogram::get_bucket_value(unsigned bucket) {
+   if (bucket < 2 * sub_buckets) return bucket;
+   unsigned msb = 4 + (bucket - 2 * sub_buckets) / sub_buckets;
+   uint64_t sub = (bucket - 2 * sub_buckets) % sub_buckets;
+   uint64_t width = uint64_t(1) << (msb - 3);
+   return (sub_buckets + sub) * width + width / 2;
+}
+
+void Histogram::record(uint64_t ns) {
+   buckets[get_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+   uint64_t current = max.load(std::memory_order_relaxed);
+   while (ns > current && !max.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+}
+
+// Percentiles from a snapshot of the buckets, taken while other threads may still record
+summary Histogram::summarise() const {
+   std::array<uint64_t, num_buckets> snapshot;
+   uint64_t total = 0;
+   for (unsigned i=0; i<num_buckets; ++i) {
+      snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+      total += snapshot[i];
+   }
+   summary result = {total, 0, 0, max.load(std::memory_order_relaxed)};
+   if (total == 0) return result;
+
+   auto percentile = [&](double q) {
+      uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * total + 0.5));
+      uint64_t seen = 0;
+      for (unsigned i=0; i<num_buckets; ++i) {
+         seen += snapshot[i];
+         if (seen >= rank) return std::min(get_bucket_value(i), result.max);
+      }
+      return result.max;
+   };
+   result.p50 = percentile(0.5);
+   result.p99 = percentile(0.99);
+   return result;
+}
+
+void Histogram::clear() {
+   for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+   max.store(0, std::memory_order_relaxed);
+}
+
+static Histogram histograms[num_probes];
+
+const char* Latency::get_name(probe p) {
+   static const char* names[num_probes] = {"pqos_mon_poll", "pqos_l3ca_set", "pqos_alloc_assoc_set", "process scan", "config read", "config write", "frame render"};
+   return p < num_probes ? names[p] : "";
+}
+
+void Latency::record(probe p, uint64_t ns) {
+   histograms[p].record(ns);
+}
+
+summary Latency::summarise(probe p) {
+   return histograms[p].summarise();
+}
+
+void Latency::clear() {
+   for (Histogram& histogram : histograms) histogram.clear();
+}
@@ -2,11 +2,16 @@
 
 using namespace Misc;
 
-std::vector<std::string> Misc::run_cmd(std::string cmd) {
+// timeout: seconds before the command is killed, 0 waits for it
+std::vector<std::string> Misc::run_cmd(std::string cmd, int timeout) {
    std::vector<std::string> result;
    FILE *stream;
    const int max_buffer = 256;
    char buffer[max_buffer];
+   if (timeout > 0) {
+      std::string quoted = std::regex_replace(cmd, std::regex("'"), "'\\''");
+      cmd = "timeout -k 1 " + std::to_string(timeout) + " sh -c '" + quoted + "'";
+   }
    cmd.append(" 2>&1");
    stream = popen(cmd.c_str(), "r");
 
@@ -21,11 +26,6 @@ std::vector<std::string> Misc::run_cmd(std::string cmd) {
    return result;
 }
 
-std::vector<std::string> Misc::get_cpu_info() {
-   std::string cmd = "lscpu | egrep 'Model name|Socket|Thread|NUMA|CPU\\(s\\)|Architecture'";
-   return run_cmd(cmd);
-}
-
 std::string Misc::format_bytes(uint64_t bytes) {
    double result;
    std::string unit;
@@ -66,6 +66,29 @@ std::string Misc::format_misses(uint64_t val) {
    else return std::to_string(val);
 }
 
+// Largest whole unit, e.g. 90 -> "1m", 7200 -> "2h"
+std::string Misc::format_duration(uint64_t seconds) {
+   if (seconds >= 86400) return std::to_string(seconds / 86400) + "d";
+   if (seconds >= 3600) return std::to_string(seconds / 3600) + "h";
+   if (seconds >= 60) return std::to_string(seconds / 60) + "m";
+   return std::to_string(seconds) + "s";
+}
+
+// Three significant digits of ns, us, ms or s
+std::string Misc::format_nanoseconds(uint64_t ns) {
+   if (ns < 1000) return std::to_string(ns) + " ns";
+   static const char* units[] = {" us", " ms", " s"};
+   double value = ns / 1000.0;
+   int unit = 0;
+   while (value >= 1000 && unit < 2) {
+      value /= 1000;
+      ++unit;
+   }
+   std::ostringstream res;
+   res << std::fixed << std::setprecision(value < 10 ? 2 : value < 100 ? 1 : 0) << value << units[unit];
+   return res.str();
+}
+
 std::string Misc::to_range_extraction(const std::set<int>& numbers) {
    if (numbers.empty()) {
       return "No cores assigned";
@@ -102,25 +125,72 @@ std::string Misc::to_range_extraction(const std::set<int>& numbers) {
    return res.str();
 }
 
-bool Misc::not_contiguous(const std::string& bitmask) {
-   bool foundOne = false;
-   for (size_t i=1; i<bitmask.size(); ++i) {
-      if (bitmask[i] == '1') {
-         if (foundOne && bitmask[i-1] != '1') return true;
-         foundOne = !foundOne || foundOne;
-      }
+// KEY=VALUE pairs, one per line, '#' starts a comment (same layout as cache_policy)
+std::map<std::string, std::string> Misc::read_key_values(const std::string& file_path) {
+   std::map<std::string, std::string> key_values;
+   std::ifstream file(file_path);
+   std::string line;
+
+   auto trim = [](const std::string& str) -> std::string {
+      size_t start = str.find_first_not_of(" \t\r\n");
+      if (start == std::string::npos) return "";
+      size_t end = str.find_last_not_of(" \t\r\n");
+      return str.substr(start, end - start + 1);
+   };
+
+   while (std::getline(file, line)) {
+      line = line.substr(0, line.find('#'));
+      size_t pos = line.find('=');
+      if (pos == std::string::npos) continue;
+      std::string key = trim(line.substr(0, pos));
+      if (!key.empty()) key_values[key] = trim(line.substr(pos + 1));
    }
-   return false;
+   return key_values;
 }
 
-// binary to decimal for updating ways mask
-unsigned Misc::to_decimal(std::string bitmask) {
-   long long n = stoll(bitmask);
-   int i=0, res=0;
-   while (n>0) {
-      res = ((n%10) * pow(2,i))+res;
-      n/=10;
-      ++i;
+// cos -> tag of the POLICY/NAME/CORES lines of a cache_policy file
+std::map<int, std::string> Misc::parse_cache_policy_tags(std::istream& file) {
+   // Initialize regex pattern
+   // 
+   // Example of a 3-part config
+   // POLICY_1=11000000000 ;  NAME_1="Junk/Root"        ;  CORES_1="0,18"
+   // POLICY_2=00111110000 ;  NAME_2="Qube Fast Path"   ;  CORES_2="1-17"
+   // POLICY_3=00000001111 ;  NAME_3="Qube Slow Path"   ;  CORES_3="19-35"
+   //
+   // five capture groups:
+   // 1 (policy number): `(\d+)`: Matches one or more digits after "POLICY_"
+   // 2 (name number): `(\d+)`: Matches one or more digits after "NAME_"
+   // 3 (tag string): `"([^"]+"`: Matches quote string after name number
+   // 4 (cores number): `(\d+)`: Matches one or more digits after "CORES_"
+   // 5 (cores string): `"([^"]+"`: Matches quote string after cores number
+
+   static const std::regex tag_regex(".*POLICY_(\\d+)=\\d+\\s*;\\s*NAME_(\\d+)=\"([^\"]+)\"\\s*;\\s*CORES_(\\d+)=\"([^\"]+).*");
+
+   std::smatch matches; // object to hold matched subexpressions
+   std::string line;
+   std::map<int, std::string> tags;
+   while (std::getline(file, line)) {
+      // check if line matches the policy regex and has the same integer value for policy, name and cores
+      if ((line.find("#") == std::string::npos) && (std::regex_match(line, matches, tag_regex))) {
+          // Extract integer values from subgroups
+          int current_policy_number = std::stoi(matches[1].str());
+          int current_name_number = std::stoi(matches[2].str());
+          int current_cores_number = std::stoi(matches[4].str());
+
+          // Check if current integers match previous integers
+          if (current_policy_number == current_name_number && current_name_number == current_cores_number) {
+             tags[current_name_number] = matches[3].str();
+          } 
+      }
    }
-   return res;
+   return tags;
+}
+
+// Processor (psr, 5th column) of a "ps ao user,pid,pcpu,pmem,psr,..." line, -1 for the header
+int Misc::get_ps_processor(const std::string& line) {
+   std::istringstream iss(line);
+   std::string field;
+   for (int column=0; column<5; ++column) iss >> field;
+   if (field.empty() || !std::all_of(field.begin(), field.end(), ::isdigit)) return -1;
+   return std::stoi(field);
 }
@@ -0,0 +1,96 @@
+#include "mrc_estimator.hpp"
+
+using namespace Autotuna;
+
+// an allocation period averages many samples at a known allocation, worth more than one occupancy sample
+static const double ALLOCATION_WEIGHT = 30.0;
+static const size_t MIN_PERIOD_SAMPLES = 10;
+
+Mrc_Estimator::Mrc_Estimator(size_t _max_observations):
+   max_observations(_max_observations)
+{
+}
+
+void Mrc_Estimator::add_observation(unsigned cos, const observation& point) {
+   std::deque<observation>& points = observations[cos];
+   if (points.size() == max_observations) points.pop_front();
+   points.push_back(point);
+}
+
+void Mrc_Estimator::add_sample(unsigned cos, int allocated_ways, double occupied_ways, uint64_t misses) {
+   if (occupied_ways >= 0.25) add_observation(cos, {occupied_ways, static_cast<double>(misses), 1.0});
+
+   // close the period when the allocation changes
+   allocation_period& period = periods[cos];
+   if (period.ways != allocated_ways) {
+      if (period.count >= MIN_PERIOD_SAMPLES) add_observation(cos, {static_cast<double>(period.ways), period.misses_sum / period.count, ALLOCATION_WEIGHT});
+      period = {allocated_ways, 0, 0};
+   }
+   period.misses_sum += misses;
+   ++period.count;
+}
+
+void Mrc_Estimator::clear(unsigned cos) {
+   observations.erase(cos);
+   periods.erase(cos);
+}
+
+/* Power law miss curve: misses(w) = a * w^(-b), b >= 0
+ * Weighted least squares on log(ways) vs log(misses + 1), points binned per half way so
+ * heavily sampled occupancies don't drown the rest.
+ * confidence = goodness of fit (R^2) x coverage of the ways range x amount of data
+*/
+mrc_estimate Autotuna::Mrc_Estimator::estimate(unsigned cos, int num_ways) {
+   mrc_estimate result = {{}, 0.0};
+   auto it = observations.find(cos);
+   if (it == observations.end() || num_ways < 1) return result;
+
+   std::map<int, std::pair<double, double>> bins; // half way bin -> (weighted log misses sum, weight)
+   std::map<int, double> bin_ways;
+   double total_weight = 0;
+   for (const observation& point : it->second) {
+      int bin = static_cast<int>(std::round(point.ways * 2));
+      bins[bin].first += point.weight * std::log(point.misses + 1.0);
+      bins[bin].second += point.weight;
+      bin_ways[bin] += point.weight * point.ways;
+      total_weight += point.weight;
+   }
+   // include the allocation period still running
+   auto period = periods.find(cos);
+   if (period != periods.end() && period->second.count >= MIN_PERIOD_SAMPLES) {
+      int bin = period->second.ways * 2;
+      bins[bin].first += ALLOCATION_WEIGHT * std::log(period->second.misses_sum / period->second.count + 1.0);
+      bins[bin].second += ALLOCATION_WEIGHT;
+      bin_ways[bin] += ALLOCATION_WEIGHT * period->second.ways;
+      total_weight += ALLOCATION_WEIGHT;
+   }
+   if (bins.size() < 3) return result;
+
+   // one point per bin, weighted by sqrt of its weight
+   double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+   double min_ways = bins.begin()->first / 2.0, max_ways = bins.rbegin()->first / 2.0;
+   for (const auto&[bin, value] : bins) {
+      double w = std::sqrt(value.second);
+      double x = std::log(bin_ways[bin] / value.second);
+      double y = value.first / value.second;
+      sw += w; sx += w * x; sy += w * y; sxx += w * x * x; sxy += w * x * y; syy += w * y * y;
+   }
+   double var_x = sxx - sx * sx / sw;
+   double var_y = syy - sy * sy / sw;
+   if (var_x <= 1e-9) return result;
+   double slope = (sxy - sx * sy / sw) / var_x;
+   double intercept = (sy - slope * sx) / sw;
+   double b = -slope;
+   if (b < 0) return result; // misses grow with ways: occupancy follows load here, not a miss curve
+
+   double r_squared = var_y > 1e-9 ? std::min(1.0, (slope * slope * var_x) / var_y) : 1.0;
+   double coverage = num_ways > 1 ? std::min(1.0, (max_ways - min_ways) / (num_ways - 1)) : 1.0;
+   double amount = std::min(1.0, total_weight / 600.0);
+   result.confidence = r_squared * std::sqrt(coverage) * amount;
+
+   for (int w=1; w<=num_ways; ++w) {
+      double misses = std::exp(intercept - b * std::log(static_cast<double>(w))) - 1.0;
+      result.misses.push_back(static_cast<uint64_t>(std::max(0.0, misses)));
+   }
+   return result;
+}
@@ -0,0 +1,40 @@
+#include "objective.hpp"
+
+using namespace Autotuna;
+
+bool Autotuna::is_misses_only(const objective_weights& weights) {
+   return weights.ipc <= 0 && weights.bandwidth <= 0 && weights.external <= 0;
+}
+
+// Average of the latest window samples, an unavailable external signal is recorded as NaN and skipped
+objective_sample Autotuna::average_sample(const std::vector<uint64_t>& misses, const std::vector<double>& ipc, const std::vector<uint64_t>& bandwidth, const std::vector<double>& external, size_t window) {
+   auto average = [&](const auto& values) -> double {
+      size_t count = 0;
+      double sum = 0.0;
+      for (size_t i = values.size() - std::min(values.size(), window); i < values.size(); ++i) {
+         if (std::isnan(static_cast<double>(values[i]))) continue;
+         sum += values[i];
+         ++count;
+      }
+      return count == 0 ? 0.0 : sum / count;
+   };
+   return {average(misses), average(ipc), average(bandwidth), average(external)};
+}
+
+/* Objective in misses units, lower is better
+ * Misses count as they are. Every other metric is normalised by its reference (target) so that
+ * being at the reference is worth threshold misses: IPC as reference / ipc, bandwidth and the
+ * external signal as value / reference. Metrics without a value or a reference are neutral.
+ * The weighted mean keeps a misses-only objective equal to the misses.
+*/
+double Autotuna::objective_value(const objective_weights& weights, const objective_sample& sample, const objective_sample& reference, double threshold) {
+   double total_weight = std::max(0.0, weights.misses) + std::max(0.0, weights.ipc) + std::max(0.0, weights.bandwidth) + std::max(0.0, weights.external);
+   if (total_weight <= 0) return sample.misses;
+
+   auto ratio = [](double value, double ref) { return value > 0 && ref > 0 ? value / ref : 1.0; };
+   double value = std::max(0.0, weights.misses) * sample.misses;
+   value += std::max(0.0, weights.ipc) * threshold * ratio(reference.ipc, sample.ipc);
+   value += std::max(0.0, weights.bandwidth) * threshold * ratio(sample.bandwidth, reference.bandwidth);
+   value += std::max(0.0, weights.external) * threshold * ratio(sample.external, reference.external);
+   return value / total_weight;
+}
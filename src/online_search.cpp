@@ -0,0 +1,148 @@
+#include "online_search.hpp"
+
+using namespace Autotuna;
+
+Online_Search::Online_Search() :
+   num_samples(0),
+   window_sum(0.0),
+   window_count(0),
+   num_trials(0),
+   trials_since_baseline(0),
+   running(false),
+   converged(false)
+{}
+
+// Allocations one way away from center: one cos donates a way to another, within the limits
+std::vector<std::map<unsigned, int>> Online_Search::neighbours(const std::map<unsigned, int>& center) {
+   std::vector<std::map<unsigned, int>> result;
+   for (const auto&[donor, donor_ways] : center) {
+      auto min_ways = limits.min_ways.find(donor);
+      if (donor_ways <= (min_ways == limits.min_ways.end() ? 1 : min_ways->second)) continue;
+      for (const auto&[receiver, receiver_ways] : center) {
+         if (receiver == donor) continue;
+         auto max_ways = limits.max_ways.find(receiver);
+         if (max_ways != limits.max_ways.end() && receiver_ways >= max_ways->second) continue;
+         std::map<unsigned, int> neighbour = center;
+         --neighbour[donor];
+         ++neighbour[receiver];
+         if (tried.find(neighbour) == tried.end()) result.push_back(neighbour);
+      }
+   }
+   return result;
+}
+
+search_step Online_Search::measure(const std::map<unsigned, int>& ways_map) {
+   current = ways_map;
+   num_samples = 0;
+   window_sum = 0.0;
+   window_count = 0;
+   return {true, current};
+}
+
+search_step Online_Search::next_trial() {
+   if (num_trials >= options.max_trials) return finish("Trial limit reached");
+   if (candidates.empty()) {
+      converged = true;
+      return finish("Converged");
+   }
+   if (trials_since_baseline >= options.rebaseline) {
+      status = "Re-measuring best allocation";
+      return measure(incumbent);
+   }
+   std::map<unsigned, int> candidate = candidates.front();
+   candidates.erase(candidates.begin());
+   tried.insert(candidate);
+   status = "Trial " + std::to_string(num_trials + 1) + "/" + std::to_string(options.max_trials);
+   return measure(candidate);
+}
+
+// Always ends on the best allocation observed
+search_step Online_Search::finish(const std::string& reason) {
+   running = false;
+   status = reason;
+   return {true, incumbent};
+}
+
+search_step Online_Search::start(const std::map<unsigned, int>& initial, const search_limits& _limits, const search_options& _options) {
+   limits = _limits;
+   options = _options;
+   options.window = std::max(1, options.window);
+   options.rebaseline = std::max(1, options.rebaseline);
+   arms.clear();
+   tried.clear();
+   incumbent = initial;
+   tried.insert(initial);
+   candidates = neighbours(initial);
+   num_trials = 0;
+   trials_since_baseline = 0;
+   running = true;
+   converged = false;
+   status = "Measuring starting allocation";
+   return measure(initial);
+}
+
+// One objective sample (priority weighted misses per second) of the allocation being measured
+search_step Online_Search::add_sample(double objective) {
+   if (!running) return {false, {}};
+   if (++num_samples <= options.settle) return {false, {}};
+
+   window_sum += objective;
+   ++window_count;
+   double window_mean = window_sum / window_count;
+   auto best = arms.find(incumbent);
+
+   // Safe window: cut a clearly worse trial short instead of waiting for the full window
+   if (current != incumbent && best != arms.end() && window_count >= std::max(3, options.window / 4) && window_mean > best->second.mean() * (1.0 + options.abort_margin)) {
+      arms[current].sum += window_mean;
+      ++arms[current].count;
+      ++num_trials;
+      ++trials_since_baseline;
+      return next_trial();
+   }
+   if (window_count < options.window) return {false, {}};
+
+   arms[current].sum += window_mean;
+   ++arms[current].count;
+   if (current == incumbent) {
+      trials_since_baseline = 0;
+      return next_trial();
+   }
+
+   ++num_trials;
+   ++trials_since_baseline;
+   if (arms[current].mean() < arms[incumbent].mean() * (1.0 - options.min_gain)) {
+      incumbent = current;
+      candidates = neighbours(incumbent);
+   }
+   return next_trial();
+}
+
+search_step Online_Search::stop() {
+   if (!running) return {false, {}};
+   return finish("Stopped");
+}
+
+bool Online_Search::is_running() {
+   return running;
+}
+
+bool Online_Search::has_converged() {
+   return converged;
+}
+
+int Online_Search::get_num_trials() {
+   return num_trials;
+}
+
+std::map<unsigned, int> Online_Search::get_best() {
+   return incumbent;
+}
+
+double Online_Search::get_best_objective() {
+   auto best = arms.find(incumbent);
+   return best == arms.end() ? 0.0 : best->second.mean();
+}
+
+std::string Online_Search::get_status() {
+   return status;
+}
@@ -0,0 +1,164 @@
+#include "optimizer.hpp"
+
+using namespace Autotuna;
+
+static const double INF = std::numeric_limits<double>::infinity();
+
+// Convex curves (diminishing returns per extra way) are solved exactly by handing out ways greedily.
+// Costs are (weighted) miss counts, so a gain rising by up to one miss is integer rounding, not a real bend
+static const double CONVEX_TOLERANCE = 1.0;
+
+bool Optimizer::is_convex(const optimizer_problem& problem) {
+   for (int i=0; i<problem.num_cos; ++i) {
+      const double* cost = &problem.cost[i * problem.num_ways];
+      for (int w=problem.min_ways[i]; w+1<problem.max_ways[i]; ++w) {
+         double gain = cost[w-1] - cost[w];
+         double next_gain = cost[w] - cost[w+1];
+         if (next_gain > gain + CONVEX_TOLERANCE) return false;
+      }
+   }
+   return true;
+}
+
+std::vector<allocation> Optimizer::solve_greedy(const optimizer_problem& problem, int num_solutions) {
+   allocation best;
+   best.ways = problem.min_ways;
+   int remaining = problem.num_ways;
+   for (const int& ways : best.ways) remaining -= ways;
+
+   // marginal gain of one more way, largest first
+   std::priority_queue<std::pair<double, int>> gains;
+   for (int i=0; i<problem.num_cos; ++i) {
+      int w = best.ways[i];
+      if (w < problem.max_ways[i]) gains.push({problem.cost[i * problem.num_ways + w - 1] - problem.cost[i * problem.num_ways + w], i});
+   }
+   while (remaining > 0 && !gains.empty() && gains.top().first >= 0) {
+      int i = gains.top().second;
+      gains.pop();
+      int w = ++best.ways[i];
+      --remaining;
+      if (w < problem.max_ways[i]) gains.push({problem.cost[i * problem.num_ways + w - 1] - problem.cost[i * problem.num_ways + w], i});
+   }
+
+   best.cost = 0;
+   for (int i=0; i<problem.num_cos; ++i) best.cost += problem.cost[i * problem.num_ways + best.ways[i] - 1];
+
+   /* Runner-ups: with convex curves the next best allocation is always one way away (moved between two cos,
+    * added or removed) from one of the allocations found so far, so each one is the cheapest such neighbour
+   */
+   std::vector<allocation> solutions = {best};
+   while (static_cast<int>(solutions.size()) < num_solutions) {
+      allocation next = {{}, INF};
+      auto consider = [&](const allocation& from, int taker, int giver) {
+         allocation candidate = from;
+         double cost = from.cost;
+         if (giver >= 0) {
+            if (candidate.ways[giver] <= problem.min_ways[giver]) return;
+            cost += problem.cost[giver * problem.num_ways + candidate.ways[giver] - 2] - problem.cost[giver * problem.num_ways + candidate.ways[giver] - 1];
+            --candidate.ways[giver];
+         }
+         if (taker >= 0) {
+            if (candidate.ways[taker] >= problem.max_ways[taker]) return;
+            cost += problem.cost[taker * problem.num_ways + candidate.ways[taker]] - problem.cost[taker * problem.num_ways + candidate.ways[taker] - 1];
+            ++candidate.ways[taker];
+         }
+         if (cost >= next.cost) return;
+         int total = 0;
+         for (const int& ways : candidate.ways) total += ways;
+         if (total > problem.num_ways) return;
+         for (const allocation& found : solutions) if (found.ways == candidate.ways) return;
+         candidate.cost = cost;
+         next = candidate;
+      };
+      for (const allocation& from : solutions) {
+         for (int taker=-1; taker<problem.num_cos; ++taker) {
+            for (int giver=-1; giver<problem.num_cos; ++giver) {
+               if (taker != giver) consider(from, taker, giver);
+            }
+         }
+      }
+      if (next.cost == INF) break;
+      solutions.push_back(next);
+   }
+   return solutions;
+}
+
+// K-best dynamic programming: cell (i, j) keeps the num_solutions cheapest ways of giving exactly j ways to the first i cos
+std::vector<allocation> Optimizer::solve_dp(const optimizer_problem& problem, int num_solutions) {
+   const int n = problem.num_cos;
+   const int W = problem.num_ways;
+   const int K = num_solutions;
+   auto cell = [&](int i, int j) -> size_t { return static_cast<size_t>(i * (W + 1) + j); };
+
+   if (table.size() < cell(n, W + 1) * K) table.resize(cell(n, W + 1) * K);
+   if (table_size.size() < cell(n, W + 1)) table_size.resize(cell(n, W + 1));
+   std::fill(table_size.begin(), table_size.begin() + cell(n, W + 1), 0);
+
+   table[cell(0, 0) * K] = {0.0, 0, -1};
+   table_size[cell(0, 0)] = 1;
+
+   for (int i=1; i<=n; ++i) {
+      const double* cost = &problem.cost[(i - 1) * W];
+      for (int j=1; j<=W; ++j) {
+         entry* best = &table[cell(i, j) * K];
+         int& size = table_size[cell(i, j)];
+         int max_w = std::min(problem.max_ways[i-1], j);
+         for (int w=problem.min_ways[i-1]; w<=max_w; ++w) {
+            const entry* prev = &table[cell(i - 1, j - w) * K];
+            int prev_size = table_size[cell(i - 1, j - w)];
+            for (int r=0; r<prev_size; ++r) {
+               double total = prev[r].cost + cost[w-1];
+               if (size == K && total >= best[K-1].cost) break; // prev is sorted, later ranks cost more
+               // insertion into the sorted top K
+               int pos = size < K ? size++ : K - 1;
+               while (pos > 0 && best[pos-1].cost > total) {
+                  best[pos] = best[pos-1];
+                  --pos;
+               }
+               best[pos] = {total, w, r};
+            }
+         }
+      }
+   }
+
+   // Collect the cheapest complete allocations, preferring those that use more ways on equal cost
+   std::vector<std::pair<double, std::pair<int, int>>> finals; // cost, (j, rank)
+   for (int j=W; j>=0; --j) {
+      for (int r=0; r<table_size[cell(n, j)]; ++r) {
+         finals.push_back({table[cell(n, j) * K + r].cost, {W - j, r}});
+      }
+   }
+   std::sort(finals.begin(), finals.end());
+   if (static_cast<int>(finals.size()) > K) finals.resize(K);
+
+   std::vector<allocation> solutions;
+   for (const auto& [total, position] : finals) {
+      allocation solution;
+      solution.cost = total;
+      solution.ways.resize(n);
+      int j = W - position.first;
+      int r = position.second;
+      for (int i=n; i>=1; --i) {
+         const entry& e = table[cell(i, j) * K + r];
+         solution.ways[i-1] = e.num_ways;
+         j -= e.num_ways;
+         r = e.prev_rank;
+      }
+      solutions.push_back(solution);
+   }
+   return solutions;
+}
+
+std::vector<allocation> Optimizer::solve(const optimizer_problem& problem, int num_solutions) {
+   if (problem.num_cos == 0 || problem.num_ways == 0 || num_solutions < 1) return {};
+
+   int total_min_ways = 0;
+   for (int i=0; i<problem.num_cos; ++i) {
+      if (problem.min_ways[i] < 1 || problem.min_ways[i] > problem.max_ways[i] || problem.max_ways[i] > problem.num_ways) return {};
+      total_min_ways += problem.min_ways[i];
+   }
+   if (total_min_ways > problem.num_ways) return {};
+
+   if (is_convex(problem)) return solve_greedy(problem, num_solutions);
+   return solve_dp(problem, num_solutions);
+}
@@ -0,0 +1,142 @@
+#include "phase_detector.hpp"
+
+using namespace Autotuna;
+
+Phase_Detector::Phase_Detector(double _k, double _h, size_t _warmup, size_t _signature_length, double _tolerance) :
+   max_boundaries(64)
+{
+   configure(_k, _h, _warmup, _signature_length, _tolerance);
+}
+
+void Phase_Detector::configure(double _k, double _h, size_t _warmup, size_t _signature_length, double _tolerance) {
+   k = _k;
+   h = _h;
+   warmup = std::max(static_cast<size_t>(2), _warmup);
+   signature_length = std::max(warmup, _signature_length);
+   tolerance = _tolerance;
+}
+
+void Phase_Detector::start_phase(cos_state& state) {
+   if (state.phase != -1) state.previous_phase = state.phase;
+   state.streams = {};
+   state.phase_sum = {};
+   state.phase_count = 0;
+   state.phase = -1;
+}
+
+// Closest known phase within tolerance on every stream, or a new phase
+int Phase_Detector::identify(unsigned cos, const std::array<double, num_streams>& signature) {
+   std::vector<std::array<double, num_streams>>& known = signatures[cos];
+   int best = -1;
+   double best_distance = 0.0;
+   for (size_t i=0; i<known.size(); ++i) {
+      double distance = 0.0;
+      bool within = true;
+      for (int s=0; s<num_streams; ++s) {
+         double scale = std::max({std::abs(known[i][s]), std::abs(signature[s]), 1e-9});
+         double relative = std::abs(known[i][s] - signature[s]) / scale;
+         // near-zero streams (idle ipc, no misses) match whatever their relative difference
+         if (relative > tolerance && std::abs(known[i][s] - signature[s]) > 1e-3) within = false;
+         distance += relative;
+      }
+      if (within && (best == -1 || distance < best_distance)) {
+         best = i;
+         best_distance = distance;
+      }
+   }
+   if (best != -1) return best;
+   known.push_back(signature);
+   return known.size() - 1;
+}
+
+phase_event Phase_Detector::add_sample(unsigned cos, double misses, double llc, double ipc) {
+   cos_state& state = states[cos];
+   const std::array<double, num_streams> sample = {misses, llc, ipc};
+   ++state.samples_seen;
+   ++state.phase_count;
+   for (int s=0; s<num_streams; ++s) state.phase_sum[s] += sample[s];
+
+   phase_event event = PHASE_NONE;
+   if (state.phase_count == signature_length && state.phase == -1) {
+      std::array<double, num_streams> signature;
+      for (int s=0; s<num_streams; ++s) signature[s] = state.phase_sum[s] / state.phase_count;
+      state.phase = identify(cos, signature);
+      // the first phase after start-up or a reset is only recorded, nothing changed phase
+      if (state.previous_phase != -1) event = PHASE_IDENTIFIED;
+      // same phase as before the boundary: a false alarm, not a phase change
+      if (state.phase == state.previous_phase && !state.boundaries.empty()) {
+         state.boundaries.pop_back();
+         event = PHASE_NONE;
+      }
+   }
+
+   bool boundary = false;
+   for (int s=0; s<num_streams; ++s) {
+      stream_state& stream = state.streams[s];
+      if (stream.count < warmup) {
+         // reference of the phase
+         ++stream.count;
+         double delta = sample[s] - stream.mean;
+         stream.mean += delta / stream.count;
+         stream.m2 += delta * (sample[s] - stream.mean);
+         continue;
+      }
+      double deviation = std::sqrt(stream.m2 / (stream.count - 1));
+      deviation = std::max(deviation, 0.05 * std::abs(stream.mean)); // ignore shifts within 5% of a steady stream
+      if (deviation <= 0) continue;
+      double z = std::clamp((sample[s] - stream.mean) / deviation, -4.0, 4.0);
+      stream.g_pos = std::max(0.0, stream.g_pos + z - k);
+      stream.g_neg = std::max(0.0, stream.g_neg - z - k);
+      if (stream.g_pos > h || stream.g_neg > h) boundary = true;
+   }
+
+   if (boundary) {
+      // a phase still being identified hasn't settled, its boundary stands and the reference restarts
+      if (state.phase != -1 || state.boundaries.empty()) {
+         state.boundaries.push_back(state.samples_seen - 1);
+         if (state.boundaries.size() > max_boundaries) state.boundaries.pop_front();
+         event = PHASE_BOUNDARY;
+      }
+      start_phase(state);
+   }
+   return event;
+}
+
+// History was reset or the workload changed, known phases no longer apply
+void Phase_Detector::clear(unsigned cos) {
+   states.erase(cos);
+   signatures.erase(cos);
+}
+
+// History restarted: boundaries and the current phase are dropped, known phases are kept
+void Phase_Detector::reset(unsigned cos) {
+   states.erase(cos);
+}
+
+// Sample not observed (analysis sweeping the ways), keeps boundaries aligned with the history
+void Phase_Detector::skip_sample(unsigned cos) {
+   ++states[cos].samples_seen;
+}
+
+// Allocation changed under the same workload: restart the reference without marking a boundary
+void Phase_Detector::rebase(unsigned cos) {
+   auto state = states.find(cos);
+   if (state == states.end()) return;
+   state->second.streams = {};
+}
+
+int Phase_Detector::get_phase(unsigned cos) {
+   auto state = states.find(cos);
+   return state == states.end() ? -1 : state->second.phase;
+}
+
+std::vector<size_t> Phase_Detector::get_boundaries(unsigned cos, size_t history_size) {
+   std::vector<size_t> indices;
+   auto state = states.find(cos);
+   if (state == states.end()) return indices;
+   for (const size_t& boundary : state->second.boundaries) {
+      size_t age = state->second.samples_seen - 1 - boundary;
+      if (age < history_size) indices.push_back(history_size - 1 - age);
+   }
+   return indices;
+}
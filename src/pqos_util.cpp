@@ -11,7 +11,22 @@ Pqos::Pqos():
    analysis_completed(false),
    autotuning_completed(false),
    run_thread(true),
-   priority_count(0)
+   priority_count(0),
+   analysis_touched_hardware(false),
+   analysis_in_progress(false),
+   last_continuous_step(0),
+   layout_unpersisted(false),
+   online_search_started(false),
+   canary_active(false),
+   canary_start(0),
+   canary_window(60),
+   experiment_active(false),
+   core_assoc_version(0),
+   interference_poll_count(0),
+   data_version(0),
+   config_version(0),
+   continuous_tuning(false),
+   online_search(false)
 {}
 
 std::string pqos_retval_msg(int retval) {
@@ -82,19 +97,115 @@ unsigned Pqos::get_l3cos_count() {
    return l3cos_count;
 }
 
-std::string Pqos::get_way_contention() {
+double Pqos::get_setting(const std::string& key, double default_val) {
+   auto it = settings.find(key);
+   if (it == settings.end()) return default_val;
+   try {
+      return std::stod(it->second);
+   } catch (const std::exception&) {
+      return default_val;
+   }
+}
+
+std::string Pqos::get_setting_string(const std::string& key, const std::string& default_val) {
+   auto it = settings.find(key);
+   return it == settings.end() ? default_val : it->second;
+}
+
+/* Per cos objective (cachetuna.conf)
+ * AUTOTUNA_OBJECTIVE_<METRIC>_<cos>: weight of MISSES (default 1), IPC, BANDWIDTH, EXTERNAL (default 0)
+ * AUTOTUNA_TARGET_<METRIC>_<cos>: reference of IPC, BANDWIDTH, EXTERNAL, the cos' average otherwise
+ * AUTOTUNA_EXTERNAL_FILE_<cos> / AUTOTUNA_EXTERNAL_CMD_<cos>: where the external signal is read from
+*/
+Autotuna::objective_weights Pqos::get_objective_weights(unsigned cos) {
+   std::string id = std::to_string(cos);
+   Autotuna::objective_weights weights;
+   weights.misses = get_setting("AUTOTUNA_OBJECTIVE_MISSES_" + id, weights.misses);
+   weights.ipc = get_setting("AUTOTUNA_OBJECTIVE_IPC_" + id, weights.ipc);
+   weights.bandwidth = get_setting("AUTOTUNA_OBJECTIVE_BANDWIDTH_" + id, weights.bandwidth);
+   weights.external = get_setting("AUTOTUNA_OBJECTIVE_EXTERNAL_" + id, weights.external);
+   return weights;
+}
+
+Autotuna::objective_sample Pqos::get_objective_reference(unsigned cos) {
+   auto snapshot = objective_references.find(cos);
+   const L3_Cos& l3_cos = l3_cos_vec[cos];
+   Autotuna::objective_sample reference = snapshot != objective_references.end() ? snapshot->second :
+      Autotuna::average_sample(l3_cos.misses, l3_cos.ipc, l3_cos.bandwidth, l3_cos.external, l3_cos.misses.size());
+
+   std::string id = std::to_string(cos);
+   reference.ipc = get_setting("AUTOTUNA_TARGET_IPC_" + id, reference.ipc);
+   reference.bandwidth = get_setting("AUTOTUNA_TARGET_BANDWIDTH_" + id, reference.bandwidth);
+   reference.external = get_setting("AUTOTUNA_TARGET_EXTERNAL_" + id, reference.external);
+   return reference;
+}
+
+// Objective of a cos averaged over its latest window samples, in misses units
+double Pqos::get_cos_objective(unsigned cos, size_t window, int threshold) {
+   std::lock_guard<std::mutex> lock(history_mutex);
+   return compute_cos_objective(cos, window, threshold);
+}
+
+double Pqos::compute_cos_objective(unsigned cos, size_t window, int threshold) {
+   const L3_Cos& l3_cos = l3_cos_vec[cos];
+   Autotuna::objective_weights weights = get_objective_weights(cos);
+   Autotuna::objective_sample sample = Autotuna::average_sample(l3_cos.misses, l3_cos.ipc, l3_cos.bandwidth, l3_cos.external, window);
+   if (Autotuna::is_misses_only(weights)) return sample.misses;
+   return Autotuna::objective_value(weights, sample, get_objective_reference(cos), threshold);
+}
+
+bool Pqos::has_custom_objective(unsigned cos) {
+   return !Autotuna::is_misses_only(get_objective_weights(cos));
+}
+
+// External signal of a cos (e.g. p99 latency), NaN if not configured or unreadable
+double Pqos::read_external_signal(const std::string& file_path, const std::string& cmd, int timeout) {
+   std::string value;
+   if (!file_path.empty()) {
+      std::ifstream infile(file_path);
+      std::getline(infile, value);
+   } else if (!cmd.empty()) {
+      std::vector<std::string> output = Misc::run_cmd(cmd, timeout);
+      if (!output.empty()) value = output[0];
+   }
+   try {
+      return std::stod(value);
+   } catch (const std::exception&) {
+      return std::nan("");
+   }
+}
+
+void Pqos::load_settings() {
+   Latency::Scoped_Timer timer(Latency::config_read);
+   settings = Misc::read_key_values(Misc::get_executable_path() + "cachetuna.conf");
+}
+
+Way_Mask Pqos::get_way_contention() {
   return way_contention;
 }
 
 std::vector<struct L3_Cos> Pqos::get_l3_cos_vec() {
+   std::lock_guard<std::mutex> lock(history_mutex);
    return l3_cos_vec;
 }
 
+// Bumped on every poll, panels showing monitoring data rebuild when it changes
+uint64_t Pqos::get_data_version() {
+   return data_version;
+}
+
+// Bumped whenever tags, bitmasks, cores, processes or priorities change
+uint64_t Pqos::get_config_version() {
+   return config_version;
+}
+
 std::vector<uint64_t> Pqos::get_cos_llc_vec(int cos) {
+   std::lock_guard<std::mutex> lock(history_mutex);
    return l3_cos_vec[cos].llc;
 }
 
 std::vector<uint64_t> Pqos::get_cos_misses_vec(int cos) {
+   std::lock_guard<std::mutex> lock(history_mutex);
    return l3_cos_vec[cos].misses;
 }
 
@@ -106,6 +217,14 @@ std::map<unsigned, std::vector<uint64_t>> Pqos::get_cos_misses_matrix() {
    return cos_misses_matrix;
 }
 
+std::map<unsigned, std::vector<uint64_t>> Pqos::get_cos_objective_matrix() {
+   return cos_objective_matrix;
+}
+
+std::map<unsigned, double> Pqos::get_estimated_curves() {
+   return estimated_curves;
+}
+
 std::map<unsigned, int> Pqos::get_priority_map() {
    return priority_map;
 }
@@ -117,28 +236,59 @@ int Pqos::get_num_active_cos() {
 }
 
 std::pair<int, int> Pqos::get_way_contention_index() {
-   int start = static_cast<int>(way_contention.find('1'));
-   int end = static_cast<int>(way_contention.find_last_of('1'));
+   int start = static_cast<int>(way_contention.first());
+   int end = static_cast<int>(way_contention.last());
    return std::make_pair(start, end);
 }
 
 std::set<int> Pqos::get_bit_assoc(int bit) {
    std::set<int> cos_set;
    for (const L3_Cos& cos : l3_cos_vec) {
-      if (cos.new_bitmask[bit] == '1' && cos.id != 0 && !cos.new_cores.empty()) {
+      if (cos.new_bitmask.test(bit) && cos.id != 0 && !cos.new_cores.empty()) {
          cos_set.insert(cos.id);
       }
    }
    return cos_set;
 }
 
+Way_Mask Pqos::get_new_bitmask(int cos) {
+   return l3_cos_vec[cos].new_bitmask;
+}
+
+// Cos of a core in the new settings, from a core -> cos table rebuilt once per config change
 int Pqos::get_core_assoc(int core) {
-   for (const L3_Cos& cos : l3_cos_vec) {
-      if (cos.new_cores.find(core) != cos.new_cores.end()) {
-         return cos.id;
+   if (core_assoc_table.size() != get_num_cores() || core_assoc_version != config_version) {
+      core_assoc_table.assign(get_num_cores(), 0);
+      for (const L3_Cos& cos : l3_cos_vec) {
+         for (const int& cos_core : cos.new_cores) {
+            if (cos_core >= 0 && cos_core < static_cast<int>(core_assoc_table.size())) core_assoc_table[cos_core] = cos.id;
+         }
+      }
+      core_assoc_version = config_version;
+   }
+   if (core < 0 || core >= static_cast<int>(core_assoc_table.size())) return 0;
+   return core_assoc_table[core];
+}
+
+/* Cores of a cos sharing a physical core with a noisy cos, per noisy cos
+ * A cos is noisy when its objective (misses for misses-only objectives) averaged over the last minute
+ * exceeds the threshold: its hyperthreads evict the sibling's L1/L2 lines and compete for its pipeline.
+*/
+std::map<unsigned, std::set<int>> Pqos::get_smt_conflicts(int cos, int threshold) {
+   std::map<unsigned, std::set<int>> conflicts;
+   if (cos == 0) return conflicts;
+   const Topology::cpu_topology& topology = Topology::get();
+   std::map<unsigned, bool> noisy;
+   std::lock_guard<std::mutex> lock(history_mutex);
+   for (const int& core : l3_cos_vec[cos].new_cores) {
+      for (const int& sibling : Cpu_Set::smt_siblings(topology, core).to_vector()) {
+         unsigned neighbour = get_core_assoc(sibling);
+         if (neighbour == 0 || neighbour == static_cast<unsigned>(cos)) continue;
+         if (!noisy.count(neighbour)) noisy[neighbour] = compute_cos_objective(neighbour, 60, threshold) > threshold;
+         if (noisy[neighbour]) conflicts[neighbour].insert(core);
       }
    }
-   return 0;
+   return conflicts;
 }
 
 std::vector<unsigned> Pqos::get_mon_data_index_vec() {
@@ -150,84 +300,100 @@ std::vector<unsigned> Pqos::get_mon_data_index_vec() {
    return index_vec;
 }
 
-std::vector<std::vector<uint64_t>> Pqos::get_all_llc_vec() {
-   std::vector<std::vector<uint64_t>> llc_vec;
+/* Decimated history of every monitored cos for a line plot: view.span samples ending view.offset
+ * samples before the latest one, reduced to at most view.columns spans through the cos' Series_Index,
+ * with the phase boundaries and the demand forecast of each column.
+*/
+std::vector<plot_series> Pqos::get_plot_series(bool misses, const plot_view& view) {
+   std::vector<plot_series> series_vec;
+   int64_t now = Autotuna::now_seconds();
+   std::lock_guard<std::mutex> lock(history_mutex);
+   std::lock_guard<std::mutex> forecast_lock(forecast_mutex);
    for (const L3_Cos& cos : l3_cos_vec) {
-      if (!cos.cores.empty())
-         llc_vec.push_back(cos.llc);
+      if (cos.cores.empty()) continue;
+      const std::vector<uint64_t>& values = misses ? cos.misses : cos.llc;
+      const Series_Index& index = misses ? cos.misses_index : cos.llc_index;
+      plot_series series = {cos.id, {}, {}, {}};
+      size_t last = values.size() - std::min(view.offset, values.size());
+      size_t first = last > view.span ? last - view.span : 0;
+      size_t count = last - first;
+      size_t num_columns = std::min(view.columns, count);
+      for (size_t column=0; column<num_columns; ++column) {
+         size_t to = first + (column + 1) * count / num_columns;
+         series.columns.push_back(index.span(values, first + column * count / num_columns, to));
+         // samples are 1 second apart, the latest one is now
+         Autotuna::demand_forecast prediction = forecaster.forecast_at(cos.id, now - static_cast<int64_t>(values.size() - to));
+         series.forecast.push_back(prediction.valid ? static_cast<uint64_t>(misses ? prediction.misses : prediction.llc) : Series_Index::no_value);
+      }
+      std::lock_guard<std::mutex> model_lock(model_mutex);
+      for (const size_t& boundary : phase_detector.get_boundaries(cos.id, values.size())) {
+         if (boundary >= first && boundary < last) series.markers.push_back((boundary - first) * num_columns / count);
+      }
+      series_vec.push_back(std::move(series));
    }
-   return llc_vec;
+   return series_vec;
+}
+
+// Samples in the longest monitoring history
+size_t Pqos::get_history_length() {
+   std::lock_guard<std::mutex> lock(history_mutex);
+   size_t length = 0;
+   for (const L3_Cos& cos : l3_cos_vec) length = std::max(length, cos.misses.size());
+   return length;
 }
 
-std::vector<std::vector<uint64_t>> Pqos::get_all_misses_vec() {
-   std::vector<std::vector<uint64_t>> misses_vec;
+// Forecast accuracy of every monitored cos over the last day
+std::string Pqos::get_forecast_summary() {
+   std::lock_guard<std::mutex> lock(forecast_mutex);
+   std::ostringstream summary;
    for (const L3_Cos& cos : l3_cos_vec) {
-      if (!cos.cores.empty())
-         misses_vec.push_back(cos.misses);
+      if (cos.id == 0 || cos.cores.empty()) continue;
+      double error = forecaster.get_error(cos.id);
+      if (error < 0) continue;
+      summary << (summary.tellp() == 0 ? "Forecast error:" : ",") << " Cos " << cos.id << " " << static_cast<int>(error * 100) << "%";
    }
-   return misses_vec;
+   return summary.str();
 }
 
 void Pqos::get_cos_tags() {
-   // Open file for reading
-   std::ifstream file("/etc/sysconfig/cache_policy");
-
-   // Initialize regex pattern
-   // 
-   // Example of a 3-part config
-   // POLICY_1=11000000000 ;  NAME_1="Junk/Root"        ;  CORES_1="0,18"
-   // POLICY_2=00111110000 ;  NAME_2="Qube Fast Path"   ;  CORES_2="1-17"
-   // POLICY_3=00000001111 ;  NAME_3="Qube Slow Path"   ;  CORES_3="19-35"
-   //
-   // five capture groups:
-   // 1 (policy number): `(\d+)`: Matches one or more digits after "POLICY_"
-   // 2 (name number): `(\d+)`: Matches one or more digits after "NAME_"
-   // 3 (tag string): `"([^"]+"`: Matches quote string after name number
-   // 4 (cores number): `(\d+)`: Matches one or more digits after "CORES_"
-   // 5 (cores string): `"([^"]+"`: Matches quote string after cores number
-
-   std::regex tag_regex(".*POLICY_(\\d+)=\\d+\\s*;\\s*NAME_(\\d+)=\"([^\"]+)\"\\s*;\\s*CORES_(\\d+)=\"([^\"]+).*");
-
-   // Initialize variables for parsing
-   std::smatch matches; // object to hold matched subexpressions
-   std::string line;
-
-   // Parse the file
-   size_t i=0;
-   while (std::getline(file, line)) {
-      int policy_number = -1, name_number = -1, cores_number = -1;
-      std::string tag_string = "", cores_string ="";
-      ++i;
-      // check if line matches the policy regex and has the same integer value for policy, name and cores
-      if ((std::regex_match(line, matches, tag_regex))  && (line.find("#") == std::string::npos)) {
-          // Extract integer values from subgroups
-          int current_policy_number = std::stoi(matches[1].str());
-          int current_name_number = std::stoi(matches[2].str());
-          int current_cores_number = std::stoi(matches[4].str());
+   std::map<int, std::string> tags;
+   {
+      Latency::Scoped_Timer timer(Latency::config_read);
+      // Open file for reading
+      std::ifstream file("/etc/sysconfig/cache_policy");
+      tags = Misc::parse_cache_policy_tags(file);
+   }
 
-          // Check if current integers match previous integers
-          if (current_policy_number == current_name_number && current_name_number == current_cores_number) {
-             // Add tag_string to vector if integers match
-             l3_cos_vec[current_name_number].tag = matches[3].str();
-             l3_cos_vec[current_name_number].new_tag = matches[3].str();
-          } 
-      }
+   // parsed off the UI thread at startup, a tag already edited by the user is kept
+   std::lock_guard<std::mutex> lock(history_mutex);
+   for (const auto&[cos, tag] : tags) {
+      if (cos < 0 || cos >= static_cast<int>(l3_cos_vec.size())) continue;
+      l3_cos_vec[cos].tag = tag;
+      if (!l3_cos_vec[cos].unsaved_changes) l3_cos_vec[cos].new_tag = tag;
    }
-   file.close();
+   ++config_version;
 }
 
+// One ps for all cores, its lines are split by the processor (psr) column
 void Pqos::update_processes_vec() {
-   for (L3_Cos& cos : l3_cos_vec) {
-      std::vector<std::string> processes;
-      for (const int& core : cos.cores) {
-         std::ostringstream cmd;
-         cmd << "ps ao user,pid,pcpu,pmem,psr,stat,start,time,command | awk '$5==\"" << core << "\" {print $0}'";
-         for (const std::string& line : Misc::run_cmd(cmd.str())) {
-            processes.push_back(line);
-         }
+   Latency::Scoped_Timer timer(Latency::process_scan);
+   std::map<int, unsigned> core_cos;
+   {
+      std::lock_guard<std::mutex> lock(history_mutex);
+      for (size_t i=0; i<l3_cos_vec.size(); ++i) {
+         for (const int& core : l3_cos_vec[i].cores) core_cos[core] = i;
       }
-      cos.processes = processes;
    }
+
+   std::vector<std::vector<std::string>> processes(l3_cos_vec.size());
+   for (const std::string& line : Misc::run_cmd("ps ao user,pid,pcpu,pmem,psr,stat,start,time,command")) {
+      auto cos = core_cos.find(Misc::get_ps_processor(line));
+      if (cos != core_cos.end()) processes[cos->second].push_back(line);
+   }
+
+   std::lock_guard<std::mutex> lock(history_mutex);
+   for (size_t i=0; i<l3_cos_vec.size(); ++i) l3_cos_vec[i].processes = processes[i];
+   ++config_version;
 }
 
 bool Pqos::start_resource_monitoring() {
@@ -235,8 +401,16 @@ bool Pqos::start_resource_monitoring() {
 
    for (auto& cos : l3_cos_vec) {
       // flush all cos' mon data
+      std::lock_guard<std::mutex> lock(history_mutex);
       cos.llc.clear();
       cos.misses.clear();
+      cos.llc_index.clear();
+      cos.misses_index.clear();
+      cos.ipc.clear();
+      cos.bandwidth.clear();
+      cos.external.clear();
+      std::lock_guard<std::mutex> model_lock(model_mutex);
+      phase_detector.reset(cos.id); // boundaries index into the history
 
       std::cout << "Creating resource monitoring data group for COS " << cos.id << std::endl;
       if (cos.cores.empty()) {
@@ -259,17 +433,26 @@ bool Pqos::start_resource_monitoring() {
    return 1;
 }
 
+// The new settings hold a trial's config while one runs, edits wait until it ends
+bool Pqos::is_config_locked() {
+   return online_searcher.is_running() || canary_active || experiment_active;
+}
+
 void Pqos::update_new_tag(const std::string& new_tag, int cos) {
+   if (is_config_locked()) return;
+   // get_cos_tags may still be filling in the tags from cache_policy
+   std::lock_guard<std::mutex> lock(history_mutex);
    l3_cos_vec[cos].new_tag = new_tag;
 
    bool &unsaved = l3_cos_vec[cos].unsaved_changes;
    if (new_tag != l3_cos_vec[cos].tag) unsaved = true;
    else unsaved = false;
+   ++config_version;
 }
 
 void Pqos::update_new_bitmask(int bit_selected, int cos) {
-   std::string &mask = l3_cos_vec[cos].new_bitmask;
-   std::set<int> &cores = l3_cos_vec[cos].new_cores;
+   if (is_config_locked()) return;
+   Way_Mask &mask = l3_cos_vec[cos].new_bitmask;
 
    // DDIO Mask -- first two bits must be the same
    std::vector<int> bit_targets;
@@ -282,102 +465,148 @@ void Pqos::update_new_bitmask(int bit_selected, int cos) {
 
    // flip bit
    for (const int& bit : bit_targets) {
-      mask[bit] = mask[bit] == '1' ? '0' : '1';
+      mask.flip(bit);
    }
 
-   if (Misc::not_contiguous(mask)) {
+   if (!mask.is_contiguous()) {
       non_contiguous_cos_set.insert(cos);
    } else {
       non_contiguous_cos_set.erase(cos);
    }
 
    unsigned &size = l3_cos_vec[cos].new_size;
-   size = std::count_if(mask.begin(), mask.end(), [&] (char bit) {return bit == '1';}) * get_l3_way_size();
+   size = mask.count() * get_l3_way_size();
 
    bool &unsaved = l3_cos_vec[cos].unsaved_changes;
    if (mask != l3_cos_vec[cos].bitmask) unsaved = true;
    else unsaved = false;
+   ++config_version;
 }
 
 void Pqos::update_new_cores(int core_selected, int cos_selected) {
+   Cpu_Set cores;
+   cores.insert(core_selected);
+   update_new_cores(cores, cos_selected);
+}
+
+/* Bulk toggle: if every core of the selection not used by another cos already belongs to the selected cos,
+ * they are unassociated; otherwise the free ones (Cos0) are associated. Cores used by other cos are left alone.
+*/
+void Pqos::update_new_cores(const Cpu_Set& cores_selected, int cos_selected) {
+   if (is_config_locked()) return;
    L3_Cos &cos = l3_cos_vec[cos_selected]; 
    std::set<int> &new_cores = cos.new_cores;
-   int assoc = get_core_assoc(core_selected);
+   std::vector<int> owned, free;
+   for (const int& core : cores_selected.to_vector()) {
+      if (core >= static_cast<int>(get_num_cores())) continue;
+      int assoc = get_core_assoc(core);
+      if (assoc == cos_selected) owned.push_back(core);
+      else if (assoc == 0) free.push_back(core);
+   }
 
-   // unassociate the selected core with the selected cos
-   if (assoc == cos_selected) {
-      new_cores.erase(core_selected);
-      l3_cos_vec[0].new_cores.insert(core_selected);
+   // unassociate the selected cores with the selected cos
+   if (free.empty()) {
+      for (const int& core : owned) {
+         new_cores.erase(core);
+         l3_cos_vec[0].new_cores.insert(core);
+      }
    }
-   // associate the selected core with the selected cos
-   else if (assoc == 0) {
-      new_cores.insert(core_selected);
-      l3_cos_vec[0].new_cores.erase(core_selected);
+   // associate the free selected cores with the selected cos
+   else {
+      for (const int& core : free) {
+         new_cores.insert(core);
+         l3_cos_vec[0].new_cores.erase(core);
+      }
    }
 
    bool &unsaved = cos.unsaved_changes;
    if (new_cores != cos.cores || cos.bitmask != cos.new_bitmask) unsaved = true;
    else unsaved = false;
+   ++config_version;
 }
 
 void Pqos::revert_changes() {
+   Tracer::Span span("revert_changes");
    
    for (size_t i=0; i<l3_cos_vec.size(); ++i) {
       L3_Cos& cos = l3_cos_vec[i];
       for (const int& core : cos.cores) {
-        pqos_alloc_assoc_set(core, cos.id);
+        Latency::timed(Latency::alloc_assoc_set, pqos_alloc_assoc_set, core, cos.id);
       }
-      l3ca_table[i].u.ways_mask = Misc::to_decimal(cos.bitmask);
+      l3ca_table[i].u.ways_mask = cos.bitmask.get_bits();
    }
-   pqos_l3ca_set(l3cat_ids[0], get_l3cos_count(), l3ca_table);
+   Latency::timed(Latency::l3ca_set, pqos_l3ca_set, l3cat_ids[0], get_l3cos_count(), l3ca_table);
+   // the trialed config is off the hardware, nothing left to observe
+   if (canary_active) {
+      canary_active = false;
+      canary_status = "Canary cancelled, previous config restored";
+   }
+   ++config_version;
 }
 
 int Pqos::apply_changes() {
-   std::stringstream policies;
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   canary_active = false; // a direct apply supersedes a canary under observation
+   experiment_active = false; // and an experiment
+   int retval = apply_to_hardware();
+   if (retval != PQOS_RETVAL_OK) return retval;
+   return commit_changes();
+}
+
+// Program the new cores and bitmasks without committing them, reverted on failure
+int Pqos::apply_to_hardware() {
+   Tracer::Span span("apply_to_hardware");
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
    for (size_t i=0; i<l3_cos_vec.size(); ++i) {
       L3_Cos& cos = l3_cos_vec[i];
       // Change core association to a corresponding class of service
       for (const int& core : cos.new_cores) {
-         if (pqos_alloc_assoc_set(core, cos.id) != PQOS_RETVAL_OK) {
+         if (Latency::timed(Latency::alloc_assoc_set, pqos_alloc_assoc_set, core, cos.id) != PQOS_RETVAL_OK) {
             revert_changes();
             return 1;
          }
       }
 
       // Update L3 Class of service's ways mask attribute
-      l3ca_table[i].u.ways_mask = Misc::to_decimal(cos.new_bitmask);
+      l3ca_table[i].u.ways_mask = cos.new_bitmask.get_bits();
+   }
+   // Set all class of service's ways mask
+   if (Latency::timed(Latency::l3ca_set, pqos_l3ca_set, l3cat_ids[0], get_l3cos_count(), l3ca_table) != PQOS_RETVAL_OK) {
+      revert_changes();
+      return 2;
+   }
+   return PQOS_RETVAL_OK;
+}
 
+// cache_policy of the staged (new_*) or the live settings
+int Pqos::write_cache_policy(bool staged) {
+   std::stringstream policies;
+   for (size_t i=0; i<l3_cos_vec.size(); ++i) {
+      L3_Cos& cos = l3_cos_vec[i];
+      const std::set<int>& cores = staged ? cos.new_cores : cos.cores;
       // Write to string for cache_policy
-      if (!cos.new_cores.empty()) {
+      if (!cores.empty()) {
          std::stringstream policy;
-         policy << "POLICY_" << cos.id << "=" << cos.new_bitmask << " ";
+         policy << "POLICY_" << cos.id << "=" << (staged ? cos.new_bitmask : cos.bitmask).to_binary() << " ";
          std::stringstream name;
-         name << "\tNAME_" << cos.id << "=\"" << cos.new_tag << "\" ";
-         std::stringstream cores;
-         cores << "\tCORES_" << cos.id << "=\"" << Misc::to_range_extraction(cos.new_cores); 
+         name << "\tNAME_" << cos.id << "=\"" << (staged ? cos.new_tag : cos.tag) << "\" ";
+         std::stringstream cores_str;
+         cores_str << "\tCORES_" << cos.id << "=\"" << Misc::to_range_extraction(cores); 
 
          policies << "\n" 
          << std::setw(15) << std::setfill(' ') << std::left << policy.str() << ";"
          << std::setw(30) << std::setfill(' ') << std::left << name.str() << ";"
-         << cores.str() << "\"";
+         << cores_str.str() << "\"";
       }
    }
-   // Set all class of service's ways mask
-   if (pqos_l3ca_set(l3cat_ids[0], get_l3cos_count(), l3ca_table) != PQOS_RETVAL_OK) {
-      revert_changes();
-      return 2;
-   }
 
-   // Only update /etc/sysconfig/cache_policy if PQoS api returns OK
-   std::string num_sockets = Misc::run_cmd("lscpu | egrep 'Socket' | cut -d: -f2 | tr -d '[:space:]'")[0];
-   std::string num_cores = Misc::run_cmd("lscpu | egrep 'Core' | cut -d: -f2 | tr -d '[:space:]'")[0];
-   std::string cpu = Misc::run_cmd("lscpu | egrep 'Model name' | cut -d: -f2 | awk '{$1=$1};1'")[0];
+   const Topology::cpu_topology& topology = Topology::get();
    std::stringstream output;
 
    output << "\n"
    << "#\n"
-   << "# " << cpu
-   << "# " << num_sockets << "x " << num_cores << " cores\n\n"
+   << "# " << topology.model_name << "\n"
+   << "# " << topology.sockets.size() << "x " << topology.cores_per_socket << " cores\n\n"
    << "WAYS=" << get_l3_num_ways() << " " 
    << "# Number of separate cache ways we can define" << "\n"
    << "WAYS_SIZE=" << (get_l3_way_size()/1024/1024) << " " 
@@ -389,35 +618,287 @@ int Pqos::apply_changes() {
    << "#POLICY_2=00111110000 ;  NAME_2=\"Qube Fast Path\"   ;  CORES_2=\"1-17\"\n"
    << "#POLICY_3=00000001111 ;  NAME_3=\"Qube Slow Path\"   ;  CORES_3=\"19-35\"\n";
 
+   Latency::Scoped_Timer timer(Latency::config_write);
    std::ofstream file(Misc::get_executable_path() + "cache_policy");
-   if (file.is_open()) {
-      file << output.str();
-      file.close();
-   } else return 3;
+   if (!file.is_open()) return 3;
+   file << output.str();
+   return PQOS_RETVAL_OK;
+}
 
-   // Cores and bitmasks updated successfully, backup original config and update struct variables
-   backup_config("backup.conf");
+// Make the new settings (already on the hardware) the live ones, without writing any file
+void Pqos::adopt_changes() {
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (persisted_config.empty()) persisted_config = serialise_config(); // first change since start-up
+   bool cores_changed = std::any_of(l3_cos_vec.begin(), l3_cos_vec.end(), [](const L3_Cos& cos) { return cos.cores != cos.new_cores; });
    for (size_t i=0; i<l3_cos_vec.size(); ++i) {
       L3_Cos& cos = l3_cos_vec[i];
+      if (cos.cores != cos.new_cores) {
+         {
+            std::lock_guard<std::mutex> model_lock(model_mutex);
+            mrc_estimator.clear(cos.id); // different workload
+            phase_detector.clear(cos.id);
+            loans.erase(cos.id);
+            for (auto& [donor, receivers] : loans) receivers.erase(cos.id);
+         }
+         std::lock_guard<std::mutex> forecast_lock(forecast_mutex);
+         forecaster.clear(cos.id);
+      } else if (cos.bitmask != cos.new_bitmask) {
+         std::lock_guard<std::mutex> model_lock(model_mutex);
+         phase_detector.rebase(cos.id); // misses and occupancy shift with the ways, not the phase
+      }
       cos.cores = cos.new_cores;
       cos.bitmask = cos.new_bitmask;
-      cos.size = std::count_if(cos.bitmask.begin(), cos.bitmask.end(), [&] (char bit) {return bit == '1';}) * get_l3_way_size();
+      cos.size = cos.bitmask.count() * get_l3_way_size();
       cos.tag = cos.new_tag;
-      update_processes_vec();
       cos.unsaved_changes = false;
    }
-   // reset pqos_mon_data_vec
-   monReset = true;
+   update_processes_vec();
+   // reset pqos_mon_data_vec, monitoring groups only depend on the cores
+   if (cores_changed) monReset = true;
+   ++config_version;
+}
+
+/* Record the config applied to the hardware in cache_policy, the backup and the cos structs
+ * backup.conf holds the config last written to cache_policy, layouts adopted in between by continuous tuning
+ * are never backed up.
+*/
+int Pqos::commit_changes() {
+   Tracer::Span span("commit_changes");
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   // Only update /etc/sysconfig/cache_policy if PQoS api returns OK
+   if (write_cache_policy(true) != PQOS_RETVAL_OK) return 3;
+
+   // Cores and bitmasks updated successfully, backup original config and update struct variables
+   adopt_changes();
+   write_config_file("backup.conf", persisted_config);
+   persisted_config = serialise_config();
+   layout_unpersisted = false;
+   return PQOS_RETVAL_OK;
+}
 
+// Write the live layout adopted by continuous tuning to cache_policy, once it has settled
+int Pqos::persist_layout() {
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (!layout_unpersisted) return PQOS_RETVAL_OK;
+   if (write_cache_policy(false) != PQOS_RETVAL_OK) return 3;
+   write_config_file("backup.conf", persisted_config);
+   persisted_config = serialise_config();
+   layout_unpersisted = false;
    return PQOS_RETVAL_OK;
 }
 
-void Pqos::backup_config(const std::string& file_name) {
+/* Canary apply: the new config runs on the hardware for an observation window before it is committed.
+ * Protected cos (CANARY_PROTECTED, the priority ranked cos otherwise) are compared against their
+ * objective averaged over the same window before the change; if any regresses beyond
+ * CANARY_MAX_REGRESSION (and by more than 1k misses, the Limit band), the old config is restored.
+ * Cos whose cores change are not compared, their monitoring groups follow the committed cores.
+*/
+int Pqos::start_canary(int threshold) {
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (canary_active) return PQOS_RETVAL_OK;
+   if (experiment_active) return 11;
+   canary_window = std::max(5, static_cast<int>(get_setting("CANARY_WINDOW", 60)));
+
+   std::set<unsigned> protected_cos;
+   std::stringstream protected_list(get_setting_string("CANARY_PROTECTED", ""));
+   std::string id;
+   while (std::getline(protected_list, id, ',')) {
+      try {
+         protected_cos.insert(std::stoul(id));
+      } catch (const std::exception&) {}
+   }
+   if (protected_cos.empty()) {
+      for (const auto&[cos, rank] : priority_map) if (rank > 0) protected_cos.insert(cos);
+   }
+   if (protected_cos.empty()) {
+      for (const L3_Cos& cos : l3_cos_vec) if (cos.id != 0) protected_cos.insert(cos.id);
+   }
+
+   canary_baseline.clear();
+   for (const unsigned& cos : protected_cos) {
+      if (cos >= l3_cos_vec.size()) continue;
+      const L3_Cos& l3_cos = l3_cos_vec[cos];
+      if (l3_cos.cores.empty() || l3_cos.cores != l3_cos.new_cores || l3_cos.misses.empty()) continue;
+      canary_baseline[cos] = get_cos_objective(cos, canary_window, threshold);
+   }
+
+   int retval = apply_to_hardware();
+   if (retval != PQOS_RETVAL_OK) return retval;
+   canary_config.clear();
+   for (const L3_Cos& cos : l3_cos_vec) canary_config.push_back({cos.new_tag, cos.new_bitmask, cos.new_cores});
+   canary_active = true;
+   canary_start = Autotuna::now_seconds();
+   canary_status = "Canary: observing";
+   return PQOS_RETVAL_OK;
+}
+
+// Called once per monitoring sample, returns -1 while observing, otherwise the apply result (10: reverted)
+int Pqos::step_canary(int threshold) {
+   Tracer::Span span("canary_step");
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (!canary_active) return -1;
+
+   int settle = 5; // samples straddling the change
+   int64_t elapsed = Autotuna::now_seconds() - canary_start;
+   if (elapsed < canary_window + settle) {
+      canary_status = "Canary: observing, " + std::to_string(canary_window + settle - elapsed) + "s left";
+      return -1;
+   }
+   canary_active = false;
+
+   double max_regression = get_setting("CANARY_MAX_REGRESSION", 0.2);
+   for (const auto&[cos, baseline] : canary_baseline) {
+      double observed = get_cos_objective(cos, canary_window, threshold);
+      if (observed > baseline * (1.0 + max_regression) && observed - baseline > 1000) {
+         revert_changes();
+         int percent = baseline > 0 ? static_cast<int>((observed / baseline - 1.0) * 100) : 100;
+         canary_status = "Canary reverted: Cos " + std::to_string(cos) + " regressed " + Misc::format_misses(static_cast<uint64_t>(baseline)) + " -> " + Misc::format_misses(static_cast<uint64_t>(observed)) + " (+" + std::to_string(percent) + "%)";
+         return 10;
+      }
+   }
+
+   // commit what was trialed, whatever the new settings hold by now
+   for (size_t i=0; i<l3_cos_vec.size() && i<canary_config.size(); ++i) {
+      L3_Cos& cos = l3_cos_vec[i];
+      cos.new_tag = canary_config[i].tag;
+      cos.new_bitmask = canary_config[i].bitmask;
+      cos.new_size = cos.new_bitmask.count() * get_l3_way_size();
+      cos.new_cores = canary_config[i].cores;
+   }
+   int retval = commit_changes();
+   if (retval != PQOS_RETVAL_OK) {
+      revert_changes();
+      canary_status = "Canary passed but the config could not be committed";
+      return retval;
+   }
+   canary_status = "Canary passed, changes committed";
+   return PQOS_RETVAL_OK;
+}
+
+bool Pqos::is_canary_active() {
+   return canary_active;
+}
+
+std::string Pqos::get_canary_status() {
+   return canary_status;
+}
+
+/* A/B experiment between two backup_config files, alternated in randomised intervals
+ * Both configs must keep every cos on its current cores, monitoring groups follow the committed cores.
+ * Nothing is committed: the committed config is restored when the experiment ends.
+*/
+int Pqos::start_experiment(const std::string& file_a, const std::string& file_b) {
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (experiment_active || canary_active || online_searcher.is_running()) return 11;
+   if (std::any_of(l3_cos_vec.begin(), l3_cos_vec.end(), [](const L3_Cos& cos) { return cos.unsaved_changes; })) return 11;
+
+   auto restore_new_settings = [&] {
+      for (L3_Cos& cos : l3_cos_vec) {
+         cos.new_tag = cos.tag;
+         cos.new_bitmask = cos.bitmask;
+         cos.new_cores = cos.cores;
+      }
+      ++config_version;
+   };
+   const std::string files[2] = {file_a, file_b};
+   for (int arm=0; arm<2; ++arm) {
+      int retval = read_config(files[arm]);
+      if (retval != PQOS_RETVAL_OK) {
+         restore_new_settings();
+         return retval;
+      }
+      experiment_bitmasks[arm].clear();
+      for (const L3_Cos& cos : l3_cos_vec) {
+         if (cos.new_cores != cos.cores) {
+            restore_new_settings();
+            return 11;
+         }
+         experiment_bitmasks[arm].push_back(cos.new_bitmask);
+      }
+      experiment_files[arm] = files[arm];
+   }
+   restore_new_settings();
+
+   int arm = experiment.start(static_cast<int>(get_setting("EXPERIMENT_DURATION", 1800)),
+                              static_cast<int>(get_setting("EXPERIMENT_MIN_INTERVAL", 30)),
+                              static_cast<int>(get_setting("EXPERIMENT_MAX_INTERVAL", 90)),
+                              static_cast<int>(get_setting("EXPERIMENT_SETTLE", 5)),
+                              static_cast<unsigned>(Autotuna::now_seconds()));
+   int retval = apply_experiment_arm(arm);
+   if (retval != PQOS_RETVAL_OK) return retval;
+   experiment_active = true;
+   experiment_status = "";
+   return PQOS_RETVAL_OK;
+}
+
+// Program an arm's bitmasks directly, the cores stay the live ones and the new settings are left alone
+int Pqos::apply_experiment_arm(int arm) {
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   for (size_t i=0; i<l3_cos_vec.size() && i<experiment_bitmasks[arm].size(); ++i) {
+      l3ca_table[i].u.ways_mask = experiment_bitmasks[arm][i].get_bits();
+   }
+   if (Latency::timed(Latency::l3ca_set, pqos_l3ca_set, l3cat_ids[0], get_l3cos_count(), l3ca_table) != PQOS_RETVAL_OK) {
+      revert_changes();
+      return 2;
+   }
+   return PQOS_RETVAL_OK;
+}
+
+// Called once per monitoring sample, returns -1 while running, otherwise the experiment result
+int Pqos::step_experiment(int threshold) {
+   Tracer::Span span("experiment_step");
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (!experiment_active) return -1;
+
+   std::map<unsigned, std::map<std::string, double>> sample;
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.id == 0 || cos.cores.empty() || cos.misses.empty()) continue;
+      sample[cos.id]["misses"] = cos.misses.back();
+      sample[cos.id]["ipc"] = cos.ipc.empty() ? 0.0 : cos.ipc.back();
+      sample[cos.id]["bandwidth"] = cos.bandwidth.empty() ? 0.0 : cos.bandwidth.back();
+      if (has_custom_objective(cos.id)) sample[cos.id]["objective"] = get_cos_objective(cos.id, 1, threshold);
+   }
+
+   int arm = experiment.get_arm();
+   int next_arm = experiment.add_sample(sample);
+   if (next_arm == arm) return -1;
+
+   if (next_arm != -1) {
+      int retval = apply_experiment_arm(next_arm);
+      if (retval == PQOS_RETVAL_OK) return -1;
+      experiment_active = false;
+      revert_changes();
+      experiment_status = "Experiment aborted, could not apply config " + std::string(next_arm == 0 ? "A" : "B");
+      return retval;
+   }
+
+   experiment_active = false;
+   revert_changes();
+   std::string report_path = Misc::get_executable_path() + "experiment_report.txt";
+   experiment.write_report(report_path, experiment_files[0], experiment_files[1], get_setting("EXPERIMENT_CONFIDENCE", 0.95));
+   experiment_status = "Finished, report written to " + report_path;
+   return PQOS_RETVAL_OK;
+}
+
+bool Pqos::is_experiment_active() {
+   return experiment_active;
+}
+
+std::string Pqos::get_experiment_status() {
+   if (!experiment_active) return experiment_status;
+   return "Running config " + std::string(experiment.get_arm() == 0 ? "A" : "B") + ", " + std::to_string(experiment.get_elapsed()) + "/" + std::to_string(experiment.get_duration()) + "s";
+}
+
+std::vector<Autotuna::experiment_row> Pqos::get_experiment_report() {
+   return experiment.report(get_setting("EXPERIMENT_CONFIDENCE", 0.95));
+}
+
+std::string Pqos::serialise_config() {
    // Parse stringstream
    std::stringstream ss;
    for (const L3_Cos& cos : l3_cos_vec) {
       ss << cos.tag << "\n";
-      ss << cos.bitmask << "\n";
+      ss << cos.bitmask.to_binary() << "\n";
       for (const int& core : cos.cores) {
          ss << core;
          if (&core != &(*cos.cores.rbegin())) {
@@ -426,17 +907,33 @@ void Pqos::backup_config(const std::string& file_name) {
       }
       ss << "\n";
    }
-  
+   return ss.str();
+}
+
+void Pqos::backup_config(const std::string& file_name) {
+   write_config_file(file_name, serialise_config());
+}
+
+void Pqos::write_config_file(const std::string& file_name, const std::string& config) {
    // Write to file
+   Latency::Scoped_Timer timer(Latency::config_write);
    std::string file_path = Misc::get_executable_path() + file_name;
    std::ofstream outfile(file_path, std::ios::out | std::ios::trunc);
    if (outfile.is_open()) {
-      outfile << ss.str();
+      outfile << config;
       outfile.close();
    }
 }
 
 int Pqos::load_config(const std::string& file_name) {
+   int retval = read_config(file_name);
+   if (retval != PQOS_RETVAL_OK) return retval;
+   return apply_changes();
+}
+
+// Read a backup_config file into the new settings of each cos
+int Pqos::read_config(const std::string& file_name) {
+   Latency::Scoped_Timer timer(Latency::config_read);
    std::string file_path = Misc::get_executable_path() + file_name;
    std::ifstream infile(file_path);
    std::string line;
@@ -451,7 +948,7 @@ int Pqos::load_config(const std::string& file_name) {
                l3_cos_vec[cos].new_tag = line;
                break;
             case 2:
-               l3_cos_vec[cos].new_bitmask = line;
+               l3_cos_vec[cos].new_bitmask = Way_Mask::from_binary(line);
                break;
             case 3:
                std::istringstream iss(line);
@@ -468,7 +965,8 @@ int Pqos::load_config(const std::string& file_name) {
          }
       }
       infile.close();
-      return apply_changes();
+      ++config_version;
+      return PQOS_RETVAL_OK;
    } else {
       return 9; // file not found
    }
@@ -487,105 +985,245 @@ void Pqos::update_priority_rank(int cos){
       --priority_count;
       priority_map[cos] = 0;
    }
+   ++config_version;
 }
 
-// PQoS processing for AutoTuna analysis 
-int Pqos::run_autotuna_analysis(int threshold, int root_cos, int num_free_ways) {
+// Identifies the topology and analysis config that checkpointed measurements belong to
+std::string Pqos::get_analysis_signature(int threshold, int root_cos, int num_free_ways) {
+   std::stringstream signature;
+   signature << "ways:" << get_l3_num_ways()
+             << ";cores:" << get_num_cores()
+             << ";cos:" << get_l3cos_count()
+             << ";contention:" << way_contention.to_binary()
+             << ";threshold:" << threshold
+             << ";root:" << root_cos
+             << ";free_ways:" << num_free_ways;
    for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.id == 0 || cos.cores.empty()) continue;
+      signature << ";cos" << cos.id << ":" << Misc::to_range_extraction(cos.cores);
+      Autotuna::objective_weights weights = get_objective_weights(cos.id);
+      if (!Autotuna::is_misses_only(weights)) {
+         signature << ":objective:" << weights.misses << "," << weights.ipc << "," << weights.bandwidth << "," << weights.external;
+      }
+   }
+   return signature.str();
+}
+
+// Leave only the cos under test on its cores with every other cos reset
+int Pqos::isolate_cos_for_analysis(unsigned cos_id) {
+   Tracer::Span span("isolate_cos", cos_id);
+   // Reset all cos configurations (pqos -R): all cores pinned to cos 0 and all ways set to 1
+   // cores
+   std::vector<int> cores(get_num_cores());
+   std::iota(cores.begin(), cores.end(), 0);
+   for (const int& core : cores) {
+      if (Latency::timed(Latency::alloc_assoc_set, pqos_alloc_assoc_set, core, 0) != PQOS_RETVAL_OK) {
+         revert_changes();
+         return 1;
+      } 
+   }
+   // bitmask
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.id == 0) continue;
+      l3ca_table[cos.id].u.ways_mask = Way_Mask::range(get_l3_num_ways(), 0, get_l3_num_ways()).get_bits();
+   }
+   if (Latency::timed(Latency::l3ca_set, pqos_l3ca_set, l3cat_ids[0], get_l3cos_count(), l3ca_table) != PQOS_RETVAL_OK) {
+      revert_changes();
+      return 2;
+   }
+
+   // Restore original assigned cores for cos currently under test
+   auto original_cores = l3_cos_vec[cos_id].cores;
+   for (const int& core : original_cores) {
+      if (Latency::timed(Latency::alloc_assoc_set, pqos_alloc_assoc_set, core, cos_id) != PQOS_RETVAL_OK) {
+         revert_changes();
+         return 1;
+      }
+   }
+   return PQOS_RETVAL_OK;
+}
+
+// Restrict the cos under test to num_ways and average its cache misses over 10 seconds
+int Pqos::measure_cos_misses(unsigned cos_id, int num_ways, int threshold, uint64_t& misses_average, uint64_t& objective_average) {
+   Tracer::Span span("measure_cos_misses", cos_id);
+   // Update and set bitmask to be tested on class of service (cos)
+   l3ca_table[cos_id].u.ways_mask = Autotuna::construct_way_mask(get_way_contention_index(), get_l3_num_ways(), num_ways, 0).get_bits();
+   if (Latency::timed(Latency::l3ca_set, pqos_l3ca_set, l3cat_ids[0], get_l3cos_count(), l3ca_table) != PQOS_RETVAL_OK) {
+      revert_changes();
+      return 2;
+   }
+
+   // Record changes in cache misses for 10 seconds
+   int end_point = get_cos_misses_vec(cos_id).size() + 10;
+   while (get_cos_misses_vec(cos_id).size() <= end_point) {
       if (!run_thread) {
          revert_changes();
          return 3;
       }
-      if (cos.id == 0 || cos.id == root_cos || cos.cores.empty()) continue; // cos 0 is default and Junk/Root does not need to be tuned
-      
-      // Reset all cos configurations (pqos -R): all cores pinned to cos 0 and all ways set to 1
-      // cores
-      std::vector<int> cores(get_num_cores());
-      std::iota(cores.begin(), cores.end(), 0);
-      for (const int& core : cores) {
-         if (pqos_alloc_assoc_set(core, 0) != PQOS_RETVAL_OK) {
-            revert_changes();
-            return 1;
-         } 
+      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+   }
+
+   // Calculate average misses for latest 10 cache misses
+   std::vector<uint64_t> misses_vec = get_cos_misses_vec(cos_id);
+   std::vector new_misses_vec(misses_vec.end() - 10, misses_vec.end());
+   uint64_t new_misses_sum = std::accumulate(new_misses_vec.begin(), new_misses_vec.end(), static_cast<uint64_t>(0));
+   misses_average = new_misses_sum / new_misses_vec.size();
+   objective_average = static_cast<uint64_t>(get_cos_objective(cos_id, new_misses_vec.size(), threshold));
+   return PQOS_RETVAL_OK;
+}
+
+// PQoS processing for AutoTuna analysis 
+int Pqos::run_autotuna_analysis(int threshold, int root_cos, int num_free_ways) {
+   Tracer::set_thread_name("autotuna analysis");
+   Tracer::Span span("autotuna_sweep");
+   // Resume measurements checkpointed by a previous run with the same topology and config
+   std::string state_path = Misc::get_executable_path() + "autotuna_state.conf";
+   std::string signature = get_analysis_signature(threshold, root_cos, num_free_ways);
+   int64_t max_age = static_cast<int64_t>(get_setting("AUTOTUNA_STATE_MAX_AGE", 3600));
+   Autotuna::analysis_state resumed_state = Autotuna::load_analysis_state(state_path, signature, max_age);
+   Autotuna::save_analysis_state(state_path, signature, resumed_state); // drop expired and foreign measurements
+
+   // Targeted re-analysis (phase change): cos outside the targets keep their previous curves
+   if (!analysis_targets.empty()) {
+      for (const auto&[cos, misses] : previous_misses_matrix) {
+         if (analysis_targets.count(cos) || misses.size() != static_cast<size_t>(num_free_ways)) continue;
+         const std::vector<uint64_t>& objective = previous_objective_matrix[cos];
+         for (int num_ways=1; num_ways<=num_free_ways; ++num_ways) {
+            uint64_t objective_value = objective.size() == misses.size() ? objective[num_ways-1] : misses[num_ways-1];
+            resumed_state[cos][num_ways] = {Autotuna::now_seconds(), misses[num_ways-1], objective_value};
+         }
       }
-      // bitmask
-      for (const L3_Cos& cos : l3_cos_vec) {
-         if (cos.id == 0) continue;
-         std::string new_bitmask = std::string(get_l3_num_ways(), '1');
-         l3ca_table[cos.id].u.ways_mask = Misc::to_decimal(new_bitmask); 
+   }
+
+   // Reuse curves measured earlier for the same workload, checked against live misses while
+   // the hardware is still in its original config
+   std::string cache_path = Misc::get_executable_path() + "autotuna_curves.db";
+   std::map<std::string, Autotuna::cached_curve> curve_cache = Autotuna::load_curve_cache(cache_path);
+   double tolerance = get_setting("AUTOTUNA_CURVE_TOLERANCE", 0.25);
+   // References of multi-metric objectives are the cos' averages before the sweep disturbs them
+   std::unique_lock<std::mutex> history_lock(history_mutex);
+   objective_references.clear();
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.cores.empty()) continue;
+      objective_references[cos.id] = Autotuna::average_sample(cos.misses, cos.ipc, cos.bandwidth, cos.external, cos.misses.size());
+   }
+
+   std::set<unsigned> cached_cos;
+   for (const L3_Cos& cos : l3_cos_vec) {
+      // cached and estimated curves only hold misses
+      if (cos.id == 0 || cos.id == root_cos || cos.cores.empty() || cos.misses.empty() || has_custom_objective(cos.id)) continue;
+      auto cached = curve_cache.find(Autotuna::workload_fingerprint(cos.processes, cos.cores.size()));
+      if (cached == curve_cache.end() || cached->second.misses.size() < num_free_ways) continue;
+
+      size_t num_samples = std::min(cos.misses.size(), static_cast<size_t>(10));
+      uint64_t live_misses = std::accumulate(cos.misses.end() - num_samples, cos.misses.end(), static_cast<uint64_t>(0)) / num_samples;
+      int live_ways = cos.bitmask.count();
+      if (!Autotuna::curve_matches(cached->second.misses, live_ways, live_misses, threshold, tolerance)) continue;
+
+      for (int num_ways=1; num_ways<=num_free_ways; ++num_ways) {
+         resumed_state[cos.id][num_ways] = {cached->second.timestamp, cached->second.misses[num_ways-1], cached->second.misses[num_ways-1]};
       }
-      if (pqos_l3ca_set(l3cat_ids[0], get_l3cos_count(), l3ca_table) != PQOS_RETVAL_OK) {
+      cached_cos.insert(cos.id);
+   }
+   history_lock.unlock();
+   // Without a cached curve, use the curve estimated from passive observations when it is trustworthy
+   double min_confidence = get_setting("AUTOTUNA_MRC_MIN_CONFIDENCE", 0.8);
+   estimated_curves.clear();
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.id == 0 || cos.id == root_cos || cos.cores.empty() || cached_cos.find(cos.id) != cached_cos.end() || has_custom_objective(cos.id)) continue;
+      std::unique_lock<std::mutex> model_lock(model_mutex);
+      Autotuna::mrc_estimate estimate = mrc_estimator.estimate(cos.id, num_free_ways);
+      model_lock.unlock();
+      if (estimate.misses.empty() || estimate.confidence < min_confidence) continue;
+
+      for (int num_ways=1; num_ways<=num_free_ways; ++num_ways) {
+         resumed_state[cos.id][num_ways] = {Autotuna::now_seconds(), estimate.misses[num_ways-1], estimate.misses[num_ways-1]};
+      }
+      estimated_curves[cos.id] = estimate.confidence;
+   }
+   analysis_touched_hardware = false;
+
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (!run_thread) {
          revert_changes();
-         return 2;
+         return 3;
       }
+      if (cos.id == 0 || cos.id == root_cos || cos.cores.empty()) continue; // cos 0 is default and Junk/Root does not need to be tuned
 
-      // Restore original assigned cores for cos currently under test
-      auto original_cores = l3_cos_vec[cos.id].cores;
-      for (const int& core : original_cores) {
-         if (pqos_alloc_assoc_set(core, cos.id) != PQOS_RETVAL_OK) {
-            revert_changes();
-            return 1;
-         }
+      // Only disturb the system if some way count of this cos has not been measured yet
+      std::map<int, Autotuna::measurement>& resumed_points = resumed_state[cos.id];
+      int num_resumed = std::count_if(resumed_points.begin(), resumed_points.end(), [&](const auto& point)
+                        { return point.first >= 1 && point.first <= num_free_ways; });
+      if (num_resumed < num_free_ways) {
+         analysis_touched_hardware = true;
+         int retval = isolate_cos_for_analysis(cos.id);
+         if (retval != PQOS_RETVAL_OK) return retval;
       }
 
       int curr_num_ways = 1;
       bool min_ways_recorded = false;
       cos_misses_matrix[cos.id] = std::vector<uint64_t>();
+      cos_objective_matrix[cos.id] = std::vector<uint64_t>();
 
       while (curr_num_ways <= num_free_ways) {
-         // Update and set bitmask to be tested on class of service (cos)
-         std::string curr_bitmask = Autotuna::construct_bitmask_str(get_way_contention_index(), get_l3_num_ways(), curr_num_ways, 0);
-         l3ca_table[cos.id].u.ways_mask = Misc::to_decimal(curr_bitmask);
-         if (pqos_l3ca_set(l3cat_ids[0], get_l3cos_count(), l3ca_table) != PQOS_RETVAL_OK) {
-            revert_changes();
-            return 2;
-         }
-
-         // Record changes in cache misses for 10 seconds
-         int end_point = get_cos_misses_vec(cos.id).size() + 10;
-         while (get_cos_misses_vec(cos.id).size() <= end_point) {
-            if (!run_thread) {
-               revert_changes();
-               return 3;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+         uint64_t misses_average, objective_average;
+         auto resumed_point = resumed_points.find(curr_num_ways);
+         if (resumed_point != resumed_points.end()) {
+            misses_average = resumed_point->second.misses;
+            objective_average = resumed_point->second.objective;
+         } else {
+            int retval = measure_cos_misses(cos.id, curr_num_ways, threshold, misses_average, objective_average);
+            if (retval != PQOS_RETVAL_OK) return retval;
+            // Checkpoint measurement so an interrupted analysis can resume from here
+            Autotuna::append_analysis_state(state_path, cos.id, curr_num_ways, misses_average, objective_average);
          }
 
-         // Calculate average misses for latest 10 cache misses
-         std::vector<uint64_t> misses_vec = get_cos_misses_vec(cos.id);
-         std::vector new_misses_vec(misses_vec.end() - 10, misses_vec.end());
-         uint64_t new_misses_sum = std::accumulate(new_misses_vec.begin(), new_misses_vec.end(), static_cast<uint64_t>(0));
-         uint64_t misses_average = new_misses_sum / new_misses_vec.size();
-
-         // Record minimum ways needed by cos for misses <= threshold
-         if (misses_average <= threshold && !min_ways_recorded) {
+         // Record minimum ways needed by cos for objective (misses by default) <= threshold
+         if (objective_average <= threshold && !min_ways_recorded) {
             autotuna_min_ways_map[cos.id] = curr_num_ways;
             min_ways_recorded = true;
          }
 
-         // Populate cos_misses_matrix
+         // Populate cos_misses_matrix, and the objective AutoTuna optimises
          cos_misses_matrix[cos.id].push_back(misses_average);
+         cos_objective_matrix[cos.id].push_back(objective_average);
          ++curr_num_ways;
       }
    
       // Check if threshold was never met even with max num_free_ways
       if (!min_ways_recorded) autotuna_min_ways_map[cos.id] = num_free_ways;
+
+      // Remember the measured curve for the next analysis of the same workload
+      if (cached_cos.find(cos.id) == cached_cos.end() && estimated_curves.find(cos.id) == estimated_curves.end() && !has_custom_objective(cos.id)) {
+         Autotuna::store_curve(cache_path, Autotuna::workload_fingerprint(cos.processes, cos.cores.size()), cos_misses_matrix[cos.id]);
+      }
    }
    return PQOS_RETVAL_OK;
 }
 
-void Pqos::process_autotuna_analysis(int threshold, int root_cos, bool& tuning_feasible, int& depth, int& save_error_code) {
-   // Clear previous analysis remains 
+void Pqos::process_autotuna_analysis(int threshold, int root_cos, bool& tuning_feasible, int& depth, int& save_error_code, std::set<unsigned> targets) {
+   Tracer::set_thread_name("autotuna");
+   Tracer::Span span("autotuna_analysis");
+   // the sweeps reprogram the hardware under the trial
+   if (canary_active || experiment_active) {
+      save_error_code = 11;
+      depth = 2;
+      return;
+   }
+   // Clear previous analysis remains, a targeted re-analysis reuses the other cos' curves
+   analysis_targets = targets;
+   previous_misses_matrix = cos_misses_matrix;
+   previous_objective_matrix = cos_objective_matrix;
    autotuna_min_ways_map.clear();
    cos_misses_matrix.clear();
+   cos_objective_matrix.clear();
 
    // Determine free ways and tunable cos (non cos 0, non Junk/Root or co with no cores assigned)
    int num_free_ways = get_l3_num_ways();
    int num_tunable_cos = get_num_active_cos();
 
    if (root_cos != -1) {
-      const auto root_bitmask = l3_cos_vec[root_cos].bitmask;
-      int num_used_ways = std::count(root_bitmask.begin(), root_bitmask.end(), '1');
+      int num_used_ways = l3_cos_vec[root_cos].bitmask.count();
       num_free_ways -= num_used_ways;
       --num_tunable_cos;
       // check if there are sufficient free ways left for tuning 
@@ -604,12 +1242,18 @@ void Pqos::process_autotuna_analysis(int threshold, int root_cos, bool& tuning_f
 
    // Execute analysis
    int scaled_threshold = threshold * 1000;
+   analysis_in_progress = true;
    std::future<int> analysis = std::async(std::launch::async, &Pqos::run_autotuna_analysis, this, scaled_threshold, root_cos, num_free_ways);
 
    save_error_code = analysis.get();
+   analysis_in_progress = false;
+   analysis_targets.clear();
+   analysis_min_ways_map = autotuna_min_ways_map;
    if (save_error_code == PQOS_RETVAL_OK) {
-      // Rollback to original configuration
-      load_config(filename);
+      // Analysis finished, checkpointed measurements are no longer needed
+      std::filesystem::remove(Misc::get_executable_path() + "autotuna_state.conf");
+      // Rollback to original configuration, nothing to roll back if every curve was reused
+      if (analysis_touched_hardware) load_config(filename);
       depth = 0;
    } else {
       save_error_code +=3;
@@ -620,56 +1264,622 @@ void Pqos::process_autotuna_analysis(int threshold, int root_cos, bool& tuning_f
    return;
 }
 
-void Pqos::process_autotuna_tuning(int root_cos, int& depth, int& save_error_code) {
+// Compute the optimal num ways for each cos and its runner-ups, without touching the hardware
+void Pqos::plan_autotuna_tuning(int root_cos) {
+   Tracer::Span span("autotuna_plan");
+   autotuna_plans.clear();
    int total_min_ways = std::accumulate(autotuna_min_ways_map.begin(), autotuna_min_ways_map.end(), 0, [](auto prev_total, auto& map) { return prev_total + map.second; });
    int remaining_ways = get_l3_num_ways() - total_min_ways;
 
-   if (remaining_ways != 0) {
-      // scale cos_misses_matrix based on each cos priority rankings
-      Autotuna::scaled_data data = Autotuna::scale_misses_matrix(cos_misses_matrix, priority_map);
-      // adjust scaled matrix according to each cos' minimum needed ways to prune final calculation
-      Autotuna::adjust_misses_matrix_values(data, autotuna_min_ways_map, root_cos, remaining_ways);
-      // determine optimal num ways for each cos
-      calculate_optimal_ways_combination(data, autotuna_min_ways_map, priority_map, root_cos); 
+   // scale cos_misses_matrix based on each cos priority rankings
+   Autotuna::scaled_data data = Autotuna::scale_misses_matrix(cos_objective_matrix, priority_map);
+   if (data.matrix.empty()) return;
+
+   if (remaining_ways == 0) {
+      // minimum needed ways fill the cache exactly
+      Autotuna::tuning_plan plan = {autotuna_min_ways_map, {}, 0.0};
+      for (size_t i=0; i<data.order.size(); ++i) plan.cost += data.matrix[i][autotuna_min_ways_map[data.order[i]] - 1];
+      autotuna_plans.push_back(plan);
+      return;
    }
-   
-   // Update new bitmask 
-   std::vector<unsigned> on_reserve;
-   std::string available_bitmask = std::string(get_l3_num_ways(), '0');
-
-   for (const auto&[cos, min_ways] : autotuna_min_ways_map) {
-      int pos_0 = static_cast<int>(available_bitmask.find('0'));
-      if (pos_0 == 0 && min_ways < 2) {
-         on_reserve.push_back(cos);
+
+   // bound each cos by its minimum needed ways, then by the user's AUTOTUNA_MIN_WAYS_<cos>/AUTOTUNA_MAX_WAYS_<cos>
+   Autotuna::ways_limits limits = Autotuna::get_ways_limits(data, autotuna_min_ways_map, remaining_ways);
+   for (const unsigned& cos : data.order) {
+      int& min_ways = limits.min_ways[cos];
+      int& max_ways = limits.max_ways[cos];
+      max_ways = std::min(max_ways, static_cast<int>(get_setting("AUTOTUNA_MAX_WAYS_" + std::to_string(cos), max_ways)));
+      min_ways = std::max(min_ways, static_cast<int>(get_setting("AUTOTUNA_MIN_WAYS_" + std::to_string(cos), min_ways)));
+      min_ways = std::min(min_ways, max_ways);
+   }
+
+   // determine optimal num ways for each cos, followed by the runner-ups
+   int num_solutions = std::max(1, static_cast<int>(get_setting("AUTOTUNA_NUM_ALTERNATIVES", 3)));
+   autotuna_plans = Autotuna::calculate_optimal_ways_combination(optimizer, data, limits, priority_map, root_cos, num_solutions);
+   // let low priority cos share ways when the contention model predicts a lower cost
+   int overlap_max_rank = static_cast<int>(get_setting("AUTOTUNA_OVERLAP_MAX_RANK", 0));
+   int max_shared_ways = static_cast<int>(get_setting("AUTOTUNA_MAX_SHARED_WAYS", 1));
+   autotuna_plans = Autotuna::consider_shared_ways(optimizer, data, limits, priority_map, overlap_max_rank, max_shared_ways, autotuna_plans);
+   for (Autotuna::tuning_plan& plan : autotuna_plans) {
+      if (root_cos != -1) plan.ways_map[root_cos] = autotuna_min_ways_map[root_cos];
+   }
+}
+
+std::vector<Autotuna::tuning_plan> Pqos::get_autotuna_plans() {
+   return autotuna_plans;
+}
+
+// Lay out contiguous new bitmasks for a plan, cos sharing ways are placed as one group
+std::map<unsigned, Way_Mask> Pqos::layout_bitmasks(const Autotuna::tuning_plan& plan) {
+   struct group {
+      unsigned head;
+      int head_ways;
+      unsigned tail;
+      int tail_ways;
+      int width;
+      bool shared;
+   };
+
+   std::vector<group> groups;
+   for (const auto&[cos, min_ways] : plan.ways_map) {
+      auto as_head = std::find_if(plan.overlaps.begin(), plan.overlaps.end(), [&](const auto& overlap) { return overlap.head == cos; });
+      auto as_tail = std::find_if(plan.overlaps.begin(), plan.overlaps.end(), [&](const auto& overlap) { return overlap.tail == cos; });
+      if (as_tail != plan.overlaps.end()) continue; // placed with its head
+      if (as_head != plan.overlaps.end()) {
+         int tail_ways = plan.ways_map.at(as_head->tail);
+         groups.push_back({cos, min_ways, as_head->tail, tail_ways, min_ways + tail_ways - as_head->num_shared, true});
+      } else {
+         groups.push_back({cos, min_ways, cos, min_ways, min_ways, false});
+      }
+   }
+
+   std::map<unsigned, Way_Mask> bitmasks;
+   std::vector<group> on_reserve;
+   Way_Mask available_bitmask(0, get_l3_num_ways());
+
+   auto place = [&](const group& g, int pos_0) {
+      available_bitmask |= Way_Mask::range(get_l3_num_ways(), pos_0, g.width);
+      if (!g.shared) {
+         bitmasks[g.head] = Autotuna::construct_way_mask(get_way_contention_index(), get_l3_num_ways(), g.width, pos_0);
+         return;
+      }
+      bitmasks[g.head] = Autotuna::construct_way_mask(get_way_contention_index(), get_l3_num_ways(), g.width, pos_0, 0, g.head_ways);
+      bitmasks[g.tail] = Autotuna::construct_way_mask(get_way_contention_index(), get_l3_num_ways(), g.width, pos_0, g.width - g.tail_ways, g.tail_ways);
+   };
+
+   for (const group& g : groups) {
+      int pos_0 = static_cast<int>(available_bitmask.first_clear());
+      // DDIO Mask -- first two bits must be the same, for the head and for a tail starting at bit 1
+      if (pos_0 == 0 && (g.head_ways < 2 || (g.shared && g.width - g.tail_ways == 1))) {
+         on_reserve.push_back(g);
          continue;
       }
-      available_bitmask.replace(pos_0, min_ways, std::string(get_l3_num_ways(), '1'), 0, min_ways);
-      l3_cos_vec[cos].new_bitmask = Autotuna::construct_bitmask_str(get_way_contention_index(), get_l3_num_ways(), min_ways, pos_0);  
+      place(g, pos_0);
    } 
 
-   for (const unsigned& cos : on_reserve) {
-      int min_ways = autotuna_min_ways_map[cos];
-      int pos_0 = static_cast<int>(available_bitmask.find('0'));
-      available_bitmask.replace(pos_0, min_ways, std::string(get_l3_num_ways(), '1'), 0, min_ways);
-      l3_cos_vec[cos].new_bitmask = Autotuna::construct_bitmask_str(get_way_contention_index(), get_l3_num_ways(), min_ways, pos_0);
+   for (const group& g : on_reserve) {
+      int pos_0 = static_cast<int>(available_bitmask.first_clear());
+      place(g, pos_0);
+   }
+   return bitmasks;
+}
+
+void Pqos::stage_bitmasks(const std::map<unsigned, Way_Mask>& bitmasks) {
+   for (const auto&[cos, bitmask] : bitmasks) l3_cos_vec[cos].new_bitmask = bitmask;
+   ++config_version;
+}
+
+std::map<unsigned, Way_Mask> Pqos::get_live_bitmasks() {
+   std::map<unsigned, Way_Mask> bitmasks;
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (!cos.cores.empty()) bitmasks[cos.id] = cos.bitmask;
+   }
+   return bitmasks;
+}
+
+std::map<unsigned, Way_Mask> Pqos::get_new_bitmasks() {
+   std::map<unsigned, Way_Mask> bitmasks;
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (!cos.new_cores.empty()) bitmasks[cos.id] = cos.new_bitmask;
+   }
+   return bitmasks;
+}
+
+// Masks a tuning plan would apply, cos outside the plan keep their live bitmask
+std::map<unsigned, Way_Mask> Pqos::get_plan_bitmasks(size_t plan_index) {
+   std::map<unsigned, Way_Mask> bitmasks = get_live_bitmasks();
+   if (plan_index >= autotuna_plans.size()) return bitmasks;
+   for (const auto&[cos, bitmask] : layout_bitmasks(autotuna_plans[plan_index])) bitmasks[cos] = bitmask;
+   return bitmasks;
+}
+
+// What-if: predict misses, occupancy and cost of a set of bitmasks from the analysed miss curves
+Autotuna::configuration_prediction Pqos::predict_configuration(const std::map<unsigned, Way_Mask>& bitmasks, int threshold) {
+   std::map<unsigned, uint64_t> demand;
+   std::unique_lock<std::mutex> history_lock(history_mutex);
+   for (const auto&[cos, bitmask] : bitmasks) {
+      const std::vector<uint64_t>& llc = l3_cos_vec[cos].llc;
+      if (llc.empty()) continue;
+      size_t window = std::min(llc.size(), static_cast<size_t>(60));
+      demand[cos] = std::accumulate(llc.end() - window, llc.end(), static_cast<uint64_t>(0)) / window;
+   }
+   history_lock.unlock();
+   return Autotuna::predict_configuration(bitmasks, cos_misses_matrix, priority_map, demand, get_l3_way_size(), threshold);
+}
+
+void Pqos::process_autotuna_tuning(int root_cos, int& depth, int& save_error_code) {
+   Tracer::Span span("autotuna_tuning");
+   {
+      std::lock_guard<std::mutex> model_lock(model_mutex);
+      loans.clear(); // the tuned layout starts afresh
+   }
+   plan_autotuna_tuning(root_cos);
+   if (!autotuna_plans.empty()) {
+      autotuna_min_ways_map = autotuna_plans[0].ways_map;
+      stage_bitmasks(layout_bitmasks(autotuna_plans[0]));
+   } else {
+      stage_bitmasks(layout_bitmasks({autotuna_min_ways_map, {}, 0.0}));
    }
 
    save_error_code = apply_changes();
    if (save_error_code == PQOS_RETVAL_OK) {
       autotuning_completed = true;
+      learn_phase_allocation();
    } else {
       save_error_code +=5;
       depth = 2;
    }
 }
 
+// Closed-loop tuning: every interval, move at most one way from an idle cos to a cos in High/Limit status
+void Pqos::step_continuous_tuning(int threshold, int root_cos) {
+   Tracer::Span span("continuous_tuning_step");
+   if (!continuous_tuning) {
+      persist_layout(); // turned off, the last layout stays on the hardware
+      return;
+   }
+   if (analysis_in_progress || experiment_active || canary_active) return;
+
+   int64_t now = Autotuna::now_seconds();
+   int64_t interval = std::max(1, static_cast<int>(get_setting("AUTOTUNA_CONTINUOUS_INTERVAL", 60)));
+   if (now - last_continuous_step < interval) return;
+   last_continuous_step = now;
+
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (std::any_of(l3_cos_vec.begin(), l3_cos_vec.end(), [](const L3_Cos& cos) { return cos.unsaved_changes; })) {
+      continuous_status = "Paused: unsaved changes";
+      return;
+   }
+
+   size_t reclaim_window = std::max(1, static_cast<int>(get_setting("AUTOTUNA_RECLAIM_WINDOW", 600)));
+   // proactive: decide on the demand forecast over the lead time, so ways move ahead of a ramp
+   int64_t forecast_lead = static_cast<int64_t>(get_setting("AUTOTUNA_FORECAST_LEAD", 0));
+
+   // Current allocation, only disjoint bitmasks can be re-laid out one way at a time
+   Autotuna::tuning_plan plan = {{}, {}, 0.0};
+   Way_Mask used_bitmask(0, get_l3_num_ways());
+   bool overlapping = false;
+   std::vector<Autotuna::cos_observation> observations;
+
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.id == 0 || cos.cores.empty()) continue;
+      int num_ways = cos.bitmask.count();
+      plan.ways_map[cos.id] = num_ways;
+      if (used_bitmask.overlaps(cos.bitmask)) overlapping = true;
+      used_bitmask |= cos.bitmask;
+      if (cos.id == root_cos || cos.misses.empty() || cos.llc.empty() || cos.size == 0) continue;
+
+      size_t misses_window = std::min(cos.misses.size(), static_cast<size_t>(interval));
+      size_t llc_window = std::min(cos.llc.size(), static_cast<size_t>(interval));
+      double misses = std::accumulate(cos.misses.end() - misses_window, cos.misses.end(), static_cast<uint64_t>(0)) / static_cast<double>(misses_window);
+      double llc = std::accumulate(cos.llc.end() - llc_window, cos.llc.end(), static_cast<uint64_t>(0)) / static_cast<double>(llc_window);
+
+      // floor: minimum needed ways from the latest analysis, or the user's AUTOTUNA_MIN_WAYS_<cos>
+      auto analysed = analysis_min_ways_map.find(cos.id);
+      int floor_ways = analysed == analysis_min_ways_map.end() ? 1 : analysed->second;
+      floor_ways = std::max(floor_ways, static_cast<int>(get_setting("AUTOTUNA_MIN_WAYS_" + std::to_string(cos.id), 1)));
+
+      auto rank = priority_map.find(cos.id);
+      float weight = Autotuna::normalise_priority_ranking(rank == priority_map.end() ? 0 : rank->second, priority_map);
+
+      // reclamation needs the occupancy to stay low over a longer window
+      double sustained_occupancy = -1;
+      if (cos.llc.size() >= reclaim_window) {
+         sustained_occupancy = std::accumulate(cos.llc.end() - reclaim_window, cos.llc.end(), static_cast<uint64_t>(0)) / static_cast<double>(reclaim_window) / cos.size;
+      }
+      Autotuna::demand_forecast forecast = {false, 0.0, 0.0};
+      if (forecast_lead > 0) {
+         std::lock_guard<std::mutex> forecast_lock(forecast_mutex);
+         forecast = forecaster.forecast(cos.id, now, now + forecast_lead);
+      }
+      observations.push_back({cos.id, num_ways, floor_ways, misses, llc / cos.size, weight, last_way_change[cos.id], sustained_occupancy, get_way_sensitivity(cos.id, num_ways, misses),
+                              forecast.valid ? forecast.misses : -1, forecast.valid ? forecast.llc / cos.size : -1});
+   }
+   if (overlapping) {
+      continuous_status = "Paused: overlapping bitmasks";
+      return;
+   }
+   std::vector<Autotuna::cos_observation> observed = observations;
+   std::transform(observations.begin(), observations.end(), observations.begin(), Autotuna::anticipate);
+
+   // Lent ways go back first, then idle ways are lent, then the regular pressure driven move
+   int64_t min_dwell = static_cast<int64_t>(get_setting("AUTOTUNA_CONTINUOUS_DWELL", 300));
+   double hysteresis = get_setting("AUTOTUNA_CONTINUOUS_HYSTERESIS", 0.5);
+   double reclaim_occupancy = get_setting("AUTOTUNA_RECLAIM_OCCUPANCY", 0.5);
+   double reclaim_sensitivity = get_setting("AUTOTUNA_RECLAIM_SENSITIVITY", 0.1) * threshold;
+   std::string action = "Moved";
+   std::unique_lock<std::mutex> model_lock(model_mutex);
+   Autotuna::way_move move = Autotuna::decide_loan_return(observations, loans, get_setting("AUTOTUNA_LOAN_RETURN_OCCUPANCY", 0.85));
+   model_lock.unlock();
+   if (move.valid) action = "Returned";
+   if (!move.valid && reclaim_occupancy > 0) {
+      move = Autotuna::decide_reclaim(observations, now, min_dwell, reclaim_occupancy, reclaim_sensitivity, threshold);
+      if (move.valid) action = "Lent";
+   }
+   if (!move.valid) move = Autotuna::decide_way_move(observations, now, min_dwell, hysteresis, threshold);
+   if (!move.valid) {
+      // a decision without a move: the layout has settled, write it to cache_policy
+      if (persist_layout() != PQOS_RETVAL_OK) continuous_status = "Watching, could not write cache_policy" + get_loans_summary();
+      else continuous_status = "Watching, no move needed" + get_loans_summary();
+      return;
+   }
+   int max_ways = static_cast<int>(get_setting("AUTOTUNA_MAX_WAYS_" + std::to_string(move.receiver), get_l3_num_ways()));
+   if (action != "Returned" && plan.ways_map[move.receiver] >= max_ways) {
+      continuous_status = "Watching, Cos " + std::to_string(move.receiver) + " at its max ways";
+      return;
+   }
+
+   // only the donor, the receiver and the cos between them change ways, the rest keep their occupancy
+   std::map<unsigned, Way_Mask> bitmasks;
+   for (const auto&[cos, ways] : plan.ways_map) bitmasks[cos] = l3_cos_vec[cos].bitmask;
+   bitmasks = Autotuna::move_one_way(bitmasks, get_way_contention_index(), move.donor, move.receiver);
+   --plan.ways_map[move.donor];
+   ++plan.ways_map[move.receiver];
+   if (bitmasks.empty()) bitmasks = layout_bitmasks(plan);
+   stage_bitmasks(bitmasks);
+   if (apply_to_hardware() != PQOS_RETVAL_OK) {
+      for (L3_Cos& cos : l3_cos_vec) cos.new_bitmask = cos.bitmask;
+      continuous_status = "Move failed, kept previous config";
+      return;
+   }
+   // moves follow each other while demand shifts, cache_policy is only written once the layout settles
+   adopt_changes();
+   layout_unpersisted = true;
+
+   last_way_change[move.donor] = now;
+   last_way_change[move.receiver] = now;
+   model_lock.lock();
+   if (action == "Lent") ++loans[move.donor][move.receiver];
+   if (action == "Returned" && --loans[move.receiver][move.donor] <= 0) {
+      loans[move.receiver].erase(move.donor);
+      if (loans[move.receiver].empty()) loans.erase(move.receiver);
+   }
+   model_lock.unlock();
+   learn_phase_allocation();
+   // the move only came from the forecast if the receiver doesn't need the way yet
+   auto receiver = std::find_if(observed.begin(), observed.end(), [&](const Autotuna::cos_observation& o) { return o.cos == move.receiver; });
+   bool forecast_driven = receiver != observed.end() && !Autotuna::needs_more_ways(*receiver, threshold);
+   std::time_t time = static_cast<std::time_t>(now);
+   std::ostringstream status;
+   status << action << " 1 way Cos " << move.donor << " -> Cos " << move.receiver << (forecast_driven ? " ahead of forecast" : "") << " at " << std::put_time(std::localtime(&time), "%H:%M:%S") << get_loans_summary();
+   continuous_status = status.str();
+}
+
+/* Extra misses a cos is expected to take from losing one of its ways: from its analysed curve,
+ * else from a confident passive estimate, else its current misses (an upper bound for an idle cos)
+*/
+double Pqos::get_way_sensitivity(unsigned cos, int num_ways, double misses) {
+   if (num_ways <= 1) return misses;
+   auto curve = cos_misses_matrix.find(cos);
+   if (curve != cos_misses_matrix.end() && curve->second.size() >= static_cast<size_t>(num_ways)) {
+      return std::max(0.0, static_cast<double>(curve->second[num_ways-2]) - static_cast<double>(curve->second[num_ways-1]));
+   }
+   std::unique_lock<std::mutex> model_lock(model_mutex);
+   Autotuna::mrc_estimate estimate = mrc_estimator.estimate(cos, num_ways);
+   model_lock.unlock();
+   if (!estimate.misses.empty() && estimate.confidence >= get_setting("AUTOTUNA_MRC_MIN_CONFIDENCE", 0.8)) {
+      return std::max(0.0, static_cast<double>(estimate.misses[num_ways-2]) - static_cast<double>(estimate.misses[num_ways-1]));
+   }
+   return misses;
+}
+
+std::string Pqos::get_loans_summary() {
+   std::lock_guard<std::mutex> model_lock(model_mutex);
+   std::string summary;
+   for (const auto&[donor, receivers] : loans) {
+      for (const auto&[receiver, num_ways] : receivers) {
+         summary += (summary.empty() ? " (lent: " : ", ") + std::to_string(num_ways) + " Cos " + std::to_string(donor) + " -> Cos " + std::to_string(receiver);
+      }
+   }
+   return summary.empty() ? summary : summary + ")";
+}
+
+// Correlate each cos' miss changes with every other cos' occupancy and bandwidth changes
+void Pqos::update_interference() {
+   size_t window = std::max(3, static_cast<int>(get_setting("AUTOTUNA_INTERFERENCE_WINDOW", 300)));
+   // copy the bitmasks and the windows of history, the scoring runs without the locks
+   std::map<unsigned, Autotuna::cos_activity> activity;
+   {
+      std::lock_guard<std::recursive_mutex> config_lock(config_mutex);
+      std::lock_guard<std::mutex> history_lock(history_mutex);
+      std::vector<const L3_Cos*> monitored;
+      for (const L3_Cos& cos : l3_cos_vec) {
+         if (cos.id == 0 || cos.cores.empty() || cos.misses.size() < 3) continue;
+         window = std::min({window, cos.misses.size(), cos.llc.size(), cos.bandwidth.size()});
+         monitored.push_back(&cos);
+      }
+
+      for (const L3_Cos* cos : monitored) {
+         Autotuna::cos_activity& cos_activity = activity[cos->id];
+         cos_activity.bitmask = cos->bitmask;
+         cos_activity.misses.assign(cos->misses.end() - window, cos->misses.end());
+         cos_activity.llc.assign(cos->llc.end() - window, cos->llc.end());
+         cos_activity.bandwidth.assign(cos->bandwidth.end() - window, cos->bandwidth.end());
+      }
+   }
+
+   Autotuna::interference_matrix matrix = Autotuna::attribute_interference(activity);
+   std::lock_guard<std::mutex> lock(interference_mutex);
+   interference = std::move(matrix);
+}
+
+Autotuna::interference_matrix Pqos::get_interference_matrix() {
+   std::lock_guard<std::mutex> lock(interference_mutex);
+   return interference;
+}
+
+// Phase of every tuned cos, empty while any of them is between phases
+std::string Pqos::get_phase_key() {
+   std::lock_guard<std::mutex> model_lock(model_mutex);
+   std::string key;
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.id == 0 || cos.cores.empty()) continue;
+      int phase = phase_detector.get_phase(cos.id);
+      if (phase == -1) return "";
+      key += std::to_string(cos.id) + ":" + std::to_string(phase) + ";";
+   }
+   return key;
+}
+
+// Remember the allocation tuned for the current combination of phases
+void Pqos::learn_phase_allocation() {
+   std::string key = get_phase_key();
+   if (key.empty()) return;
+   std::map<unsigned, int>& ways_map = phase_allocations[key];
+   ways_map.clear();
+   for (const L3_Cos& cos : l3_cos_vec) {
+      if (cos.id == 0 || cos.cores.empty()) continue;
+      ways_map[cos.id] = cos.bitmask.count();
+   }
+}
+
+/* React to cos entering a new phase (AUTOTUNA_PHASE_ACTION)
+ * 0: only mark the boundaries, 1: apply the allocation learned for a recognised combination of phases,
+ * 2: as 1, and request a re-analysis of the cos that changed phase when nothing was learned yet.
+ * Returns true when the re-analysis of targets should be started.
+*/
+bool Pqos::step_phase_tuning(std::set<unsigned>& targets) {
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   std::unique_lock<std::mutex> model_lock(model_mutex);
+   if (phase_changes.empty()) return false;
+   std::set<unsigned> changed_cos;
+   changed_cos.swap(phase_changes);
+
+   std::string changed_str;
+   for (const unsigned& cos : changed_cos) changed_str += " Cos " + std::to_string(cos) + " -> phase " + std::to_string(phase_detector.get_phase(cos));
+   model_lock.unlock();
+   std::time_t time = static_cast<std::time_t>(Autotuna::now_seconds());
+   std::ostringstream status;
+   status << "Phase change at " << std::put_time(std::localtime(&time), "%H:%M:%S") << ":" << changed_str;
+   phase_status = status.str();
+
+   int action = static_cast<int>(get_setting("AUTOTUNA_PHASE_ACTION", 0));
+   if (action == 0) return false;
+   if (analysis_in_progress || experiment_active || canary_active || online_searcher.is_running()) return false;
+   if (std::any_of(l3_cos_vec.begin(), l3_cos_vec.end(), [](const L3_Cos& cos) { return cos.unsaved_changes; })) return false;
+
+   std::string key = get_phase_key();
+   if (key.empty()) return false;
+   auto learned = phase_allocations.find(key);
+   if (learned == phase_allocations.end()) {
+      if (action < 2) return false;
+      targets = changed_cos;
+      phase_status += ", re-analysing";
+      return true;
+   }
+
+   std::map<unsigned, Way_Mask> bitmasks = layout_bitmasks({learned->second, {}, 0.0});
+   if (std::all_of(bitmasks.begin(), bitmasks.end(), [&](const auto& entry) { return l3_cos_vec[entry.first].bitmask == entry.second; })) return false;
+   stage_bitmasks(bitmasks);
+   if (apply_changes() != PQOS_RETVAL_OK) {
+      for (L3_Cos& cos : l3_cos_vec) cos.new_bitmask = cos.bitmask;
+      phase_status += ", failed to apply learned allocation";
+      return false;
+   }
+   model_lock.lock();
+   loans.clear();
+   model_lock.unlock();
+   phase_status += ", applied learned allocation";
+   return false;
+}
+
+std::string Pqos::get_phase_status() {
+   return phase_status;
+}
+
+std::string Pqos::get_continuous_status() {
+   return continuous_status;
+}
+
+// Stage and apply an allocation requested by the online search, false if it could not be applied
+/* Trials are only programmed into the hardware, new_bitmask holds the trial and bitmask the committed allocation.
+ * Once the search is over the incumbent it left on the hardware is committed.
+*/
+bool Pqos::apply_search_step(const Autotuna::search_step& step) {
+   if (step.apply) {
+      // a neighbour one way away is moved in place, so the cos outside the move keep their occupancy
+      std::map<unsigned, Way_Mask> staged;
+      std::vector<unsigned> donors;
+      std::vector<unsigned> receivers;
+      bool one_way_apart = true;
+      for (const auto&[cos, ways] : step.ways_map) {
+         staged[cos] = l3_cos_vec[cos].new_bitmask;
+         int difference = ways - static_cast<int>(staged[cos].count());
+         if (difference == -1) donors.push_back(cos);
+         else if (difference == 1) receivers.push_back(cos);
+         else if (difference != 0) one_way_apart = false;
+      }
+      std::map<unsigned, Way_Mask> bitmasks;
+      if (one_way_apart && donors.empty() && receivers.empty()) bitmasks = staged;
+      else if (one_way_apart && donors.size() == 1 && receivers.size() == 1) bitmasks = Autotuna::move_one_way(staged, get_way_contention_index(), donors[0], receivers[0]);
+      if (bitmasks.empty()) bitmasks = layout_bitmasks({step.ways_map, {}, 0.0});
+      if (!std::all_of(bitmasks.begin(), bitmasks.end(), [&](const auto& entry) { return l3_cos_vec[entry.first].new_bitmask == entry.second; })) {
+         stage_bitmasks(bitmasks);
+         if (apply_to_hardware() != PQOS_RETVAL_OK) {
+            // reverted to the committed allocation
+            for (L3_Cos& cos : l3_cos_vec) cos.new_bitmask = cos.bitmask;
+            return false;
+         }
+      }
+   }
+   if (online_searcher.is_running()) return true;
+   if (std::all_of(l3_cos_vec.begin(), l3_cos_vec.end(), [](const L3_Cos& cos) { return cos.new_bitmask == cos.bitmask; })) return true;
+   if (commit_changes() != PQOS_RETVAL_OK) {
+      for (L3_Cos& cos : l3_cos_vec) cos.new_bitmask = cos.bitmask;
+      revert_changes();
+      return false;
+   }
+   return true;
+}
+
+/* Online search: the DP assumes a cos' misses only depend on its own ways, bandwidth and DDIO
+ * interference break that. Starting from the DP's answer, trial allocations one way away on the
+ * live system and keep the one with the lowest measured priority weighted misses.
+ * Called once per monitoring sample.
+*/
+void Pqos::step_online_search(int threshold, int root_cos) {
+   Tracer::Span span("online_search_step");
+   std::lock_guard<std::recursive_mutex> lock(config_mutex);
+   if (!online_search || continuous_tuning || analysis_in_progress) {
+      if (online_searcher.is_running()) {
+         if (apply_search_step(online_searcher.stop())) online_search_status = "Stopped, kept best allocation";
+         else online_search_status = "Stopped, failed to apply best allocation, kept previous config";
+      }
+      if (!online_search) online_search_started = false;
+      else if (continuous_tuning) online_search_status = "Paused: continuous tuning is on";
+      return;
+   }
+
+   if (!online_searcher.is_running()) {
+      if (online_search_started) return; // finished, toggle to search again
+      if (experiment_active || canary_active) {
+         online_search_status = "Paused: experiment or canary running";
+         return;
+      }
+      if (std::any_of(l3_cos_vec.begin(), l3_cos_vec.end(), [](const L3_Cos& cos) { return cos.unsaved_changes; })) {
+         online_search_status = "Paused: unsaved changes";
+         return;
+      }
+
+      std::map<unsigned, int> live_ways;
+      Way_Mask used_bitmask(0, get_l3_num_ways());
+      for (const L3_Cos& cos : l3_cos_vec) {
+         if (cos.id == 0 || cos.cores.empty()) continue;
+         live_ways[cos.id] = cos.bitmask.count();
+         if (used_bitmask.overlaps(cos.bitmask)) {
+            online_search_status = "Paused: overlapping bitmasks";
+            return;
+         }
+         used_bitmask |= cos.bitmask;
+      }
+      if (live_ways.empty()) return;
+
+      // start from the DP's answer when it covers the same cos, the live allocation otherwise
+      std::map<unsigned, int> initial = live_ways;
+      if (!autotuna_plans.empty() && autotuna_plans[0].overlaps.empty()) {
+         const std::map<unsigned, int>& planned = autotuna_plans[0].ways_map;
+         bool same_cos = planned.size() == live_ways.size() && std::all_of(planned.begin(), planned.end(), [&](const auto& entry) { return live_ways.count(entry.first); });
+         if (same_cos) initial = planned;
+      }
+
+      Autotuna::search_limits limits;
+      for (const auto&[cos, ways] : initial) {
+         limits.min_ways[cos] = std::max(1, static_cast<int>(get_setting("AUTOTUNA_MIN_WAYS_" + std::to_string(cos), 1)));
+         limits.max_ways[cos] = static_cast<int>(get_setting("AUTOTUNA_MAX_WAYS_" + std::to_string(cos), get_l3_num_ways()));
+      }
+      Autotuna::search_options options = {
+         static_cast<int>(get_setting("AUTOTUNA_SEARCH_SETTLE", 5)),
+         static_cast<int>(get_setting("AUTOTUNA_SEARCH_WINDOW", 30)),
+         get_setting("AUTOTUNA_SEARCH_ABORT_MARGIN", 0.5),
+         get_setting("AUTOTUNA_SEARCH_MIN_GAIN", 0.02),
+         static_cast<int>(get_setting("AUTOTUNA_SEARCH_MAX_TRIALS", 40)),
+         static_cast<int>(get_setting("AUTOTUNA_SEARCH_REBASELINE", 5)),
+      };
+      online_search_started = true;
+      online_search_status.clear();
+      if (!apply_search_step(online_searcher.start(initial, limits, options))) {
+         online_searcher.stop();
+         online_search_status = "Failed to apply starting allocation";
+      }
+      return;
+   }
+
+   // objective: priority weighted objectives of the latest sample, Junk/Root is free to lose performance
+   double objective = 0.0;
+   for (const auto&[cos, ways] : online_searcher.get_best()) {
+      if (cos == root_cos || l3_cos_vec[cos].misses.empty()) continue;
+      auto rank = priority_map.find(cos);
+      objective += Autotuna::normalise_priority_ranking(rank == priority_map.end() ? 0 : rank->second, priority_map) * get_cos_objective(cos, 1, threshold);
+   }
+
+   Autotuna::search_step step = online_searcher.add_sample(objective);
+   if (!apply_search_step(step)) {
+      // the hardware is back at the committed allocation, restore the incumbent from there
+      if (online_searcher.is_running() && apply_search_step(online_searcher.stop())) online_search_status = "Trial failed to apply, kept best allocation";
+      else online_search_status = "Failed to apply best allocation, kept previous config";
+   }
+}
+
+/* Latest external signal of a cos, one sample per second
+ * The file or command is read in the background every AUTOTUNA_EXTERNAL_INTERVAL seconds and killed after
+ * AUTOTUNA_EXTERNAL_TIMEOUT, in between the last value is repeated. NaN until the first read completes.
+*/
+double Pqos::sample_external_signal(unsigned cos) {
+   auto reader = external_readers.find(cos);
+   if (reader == external_readers.end()) reader = external_readers.emplace(cos, external_reader{{}, 0, std::nan("")}).first;
+   external_reader& external = reader->second;
+   if (external.pending.valid() && external.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      external.value = external.pending.get();
+   }
+   int64_t now = Autotuna::now_seconds();
+   int64_t interval = std::max(1, static_cast<int>(get_setting("AUTOTUNA_EXTERNAL_INTERVAL", 5)));
+   if (!external.pending.valid() && now - external.last_read >= interval) {
+      std::string file_path = get_setting_string("AUTOTUNA_EXTERNAL_FILE_" + std::to_string(cos), "");
+      std::string cmd = get_setting_string("AUTOTUNA_EXTERNAL_CMD_" + std::to_string(cos), "");
+      int timeout = std::max(1, static_cast<int>(get_setting("AUTOTUNA_EXTERNAL_TIMEOUT", 2)));
+      external.pending = std::async(std::launch::async, &Pqos::read_external_signal, file_path, cmd, timeout);
+      external.last_read = now;
+   }
+   return external.value;
+}
+
+std::string Pqos::get_online_search_status() {
+   if (!online_search_started || (!online_searcher.is_running() && !online_search_status.empty())) return online_search_status;
+   std::string status = online_searcher.get_status() + ", " + std::to_string(online_searcher.get_num_trials()) + " trials";
+   double best = online_searcher.get_best_objective();
+   if (best > 0) status += ", best " + Misc::format_misses(static_cast<uint64_t>(best));
+   return status;
+}
+
 void Pqos::poll_mon_group() {
+   Tracer::Span span("poll_mon_group");
    if (monInitialised) {
       if (monReset) {
          pqos_mon_data_vec.clear();
          start_resource_monitoring();
          monReset = false;
       } else {
+         bool rollups_changed = false;
          // Set the max amount of data points that can be stored
          // poll rate: 1hz
          int max_size = 3600 * 24; // 24 hours
@@ -680,17 +1890,60 @@ void Pqos::poll_mon_group() {
             auto& mon = pqos_mon_data_vec[i];
 
             if (mon != NULL) {
-               ret = pqos_mon_poll(&mon, 1);
+               ret = Latency::timed(Latency::mon_poll, pqos_mon_poll, &mon, 1);
                if (ret == PQOS_RETVAL_OK) {
+                  bool has_external = get_objective_weights(cos.id).external > 0;
+                  double external = has_external ? sample_external_signal(cos.id) : 0.0;
                   // evict first element if exceed size
-                  if (cos.llc.size() == max_size) cos.llc.erase(cos.llc.begin());
-                  if (cos.misses.size() == max_size) cos.misses.erase(cos.misses.begin());
-                  // Append llc and misses of each cos
+                  std::unique_lock<std::mutex> history_lock(history_mutex);
+                  if (cos.llc.size() == max_size) {
+                     cos.llc.erase(cos.llc.begin());
+                     cos.llc_index.pop_front();
+                  }
+                  if (cos.misses.size() == max_size) {
+                     cos.misses.erase(cos.misses.begin());
+                     cos.misses_index.pop_front();
+                  }
+                  if (cos.ipc.size() == max_size) cos.ipc.erase(cos.ipc.begin());
+                  if (cos.bandwidth.size() == max_size) cos.bandwidth.erase(cos.bandwidth.begin());
+                  if (cos.external.size() == max_size) cos.external.erase(cos.external.begin());
+                  // Append llc and misses of each cos, and the other metrics objectives can weigh
                   cos.llc.push_back(mon->values.llc);
                   cos.misses.push_back(mon->values.llc_misses_delta);
+                  cos.llc_index.push(mon->values.llc);
+                  cos.misses_index.push(mon->values.llc_misses_delta);
+                  cos.ipc.push_back(mon->values.ipc);
+                  cos.bandwidth.push_back(mon->values.mbm_total_delta);
+                  if (has_external) cos.external.push_back(external);
+                  history_lock.unlock();
+                  Tracer::counter("llc", cos.id, mon->values.llc);
+                  Tracer::counter("misses", cos.id, mon->values.llc_misses_delta);
+                  Tracer::counter("ipc", cos.id, mon->values.ipc);
+                  // passive miss curve observations, analysis sweeps don't run at the committed allocation
+                  if (!analysis_in_progress && !canary_active && !experiment_active && !online_searcher.is_running() && get_l3_way_size() > 0) {
+                     int allocated_ways = cos.bitmask.count();
+                     std::unique_lock<std::mutex> model_lock(model_mutex);
+                     mrc_estimator.add_sample(cos.id, allocated_ways, static_cast<double>(mon->values.llc) / get_l3_way_size(), mon->values.llc_misses_delta);
+                     if (phase_detector.add_sample(cos.id, mon->values.llc_misses_delta, mon->values.llc, mon->values.ipc) == Autotuna::PHASE_IDENTIFIED) {
+                        phase_changes.insert(cos.id);
+                     }
+                     model_lock.unlock();
+                     std::lock_guard<std::mutex> lock(forecast_mutex);
+                     rollups_changed |= forecaster.add_sample(cos.id, Autotuna::now_seconds(), mon->values.llc_misses_delta, mon->values.llc);
+                  } else {
+                     std::lock_guard<std::mutex> model_lock(model_mutex);
+                     phase_detector.skip_sample(cos.id);
+                  }
                 }
             }
          }
+         // attribution is refreshed every 10 samples, correlations barely move in between
+         if (++interference_poll_count % 10 == 0) update_interference();
+         ++data_version;
+         if (rollups_changed) {
+            std::lock_guard<std::mutex> lock(forecast_mutex);
+            forecaster.save(Misc::get_executable_path() + "forecast_rollups.db");
+         }
       }
    }
 }
@@ -711,7 +1964,46 @@ int Pqos::close() {
    return exit_val;
 }
 
-void Pqos::init() {
+/* Startup stages, topology is all the UI needs to show its first frame
+ * settings ----------> forecast rollups
+ *           \
+ * topology ---+-------> monitoring
+ *             +-------> tags
+ *             +-------> processes
+*/
+void Pqos::init(Startup_Graph& startup) {
+   startup.add_stage("settings", {}, [this] {
+      load_settings();
+      std::lock_guard<std::mutex> model_lock(model_mutex);
+      phase_detector.configure(0.5, get_setting("AUTOTUNA_PHASE_THRESHOLD", 10), static_cast<size_t>(get_setting("AUTOTUNA_PHASE_WARMUP", 60)),
+                               static_cast<size_t>(get_setting("AUTOTUNA_PHASE_SIGNATURE", 90)), get_setting("AUTOTUNA_PHASE_TOLERANCE", 0.25));
+      forecaster.configure(static_cast<int64_t>(get_setting("AUTOTUNA_FORECAST_BUCKET", 300)), static_cast<int64_t>(get_setting("AUTOTUNA_FORECAST_SEASON", 86400)),
+                           get_setting("AUTOTUNA_FORECAST_ALPHA", 0.3), get_setting("AUTOTUNA_FORECAST_BETA", 0.05), get_setting("AUTOTUNA_FORECAST_GAMMA", 0.2), get_setting("AUTOTUNA_FORECAST_DAMPING", 0.98));
+      return true;
+   });
+   startup.add_stage("forecast_rollups", {"settings"}, [this] {
+      std::lock_guard<std::mutex> lock(forecast_mutex);
+      forecaster.load(Misc::get_executable_path() + "forecast_rollups.db", Autotuna::now_seconds());
+      return true;
+   });
+   startup.add_stage("topology", {}, [this] { return init_topology(); });
+   startup.add_stage("tags", {"topology"}, [this] {
+      get_cos_tags();
+      return true;
+   });
+   startup.add_stage("processes", {"topology"}, [this] {
+      update_processes_vec();
+      return true;
+   });
+   startup.add_stage("monitoring", {"settings", "topology"}, [this] {
+      std::cout << "PQoS init - starting resource monitoring!" << std::endl;
+      monInitialised = start_resource_monitoring();
+      return monInitialised;
+   });
+}
+
+// Library, capabilities, classes of service and core associations
+bool Pqos::init_topology() {
    /* config */
    memset(&config, 0, sizeof(config));
    config.fd_log = STDOUT_FILENO;
@@ -725,7 +2017,7 @@ void Pqos::init() {
       std::cout << pqos_retval_msg(ret) << std::endl;
       exit_val = EXIT_FAILURE;
       Pqos::close();
-      return;
+      return false;
    }
 
    /* Cache and CPU Capabilities */
@@ -735,7 +2027,7 @@ void Pqos::init() {
       std::cout << pqos_retval_msg(ret) << std::endl;
       exit_val = EXIT_FAILURE;
       Pqos::close();
-      return;
+      return false;
    }
 
    /*  L3 Cache Allocation Technology (CAT) from CPU structure */
@@ -744,7 +2036,7 @@ void Pqos::init() {
       std::cout << "Error retrieving PQoS L3 Cache Allocation Technology (CAT) ids!" << std::endl;
       exit_val = EXIT_FAILURE;
       Pqos::close();
-      return;
+      return false;
    }
 
    /* Number of L3 allocation classes of service from cap structure*/
@@ -754,7 +2046,7 @@ void Pqos::init() {
       std::cout << pqos_retval_msg(ret) << std::endl;
       exit_val = EXIT_FAILURE;
       Pqos::close();
-      return;
+      return false;
    }
 
    /* Read L3 classes of service from a socket */
@@ -765,7 +2057,7 @@ void Pqos::init() {
       std::cout << pqos_retval_msg(ret) << std::endl;
       exit_val = EXIT_FAILURE;
       Pqos::close();
-      return;
+      return false;
    }
 
    /* Retreive monitoring capabilities */
@@ -775,7 +2067,7 @@ void Pqos::init() {
       std::cout << pqos_retval_msg(ret) << std::endl;
       exit_val = EXIT_FAILURE;
       Pqos::close();
-      return;
+      return false;
    }
 
    /* Event combinations of monitoring events */
@@ -791,11 +2083,11 @@ void Pqos::init() {
       std::cout << pqos_retval_msg(ret) << std::endl;
       exit_val = EXIT_FAILURE;
       Pqos::close();
-      return;
+      return false;
    }
 
    /* Way contention of L3CA */
-   way_contention = std::bitset<sizeof(unsigned) * 8>(l3ca_cap_ptr->u.l3ca->way_contention).to_string().substr(sizeof(unsigned) * 8 - get_l3_num_ways());
+   way_contention = Way_Mask(l3ca_cap_ptr->u.l3ca->way_contention, get_l3_num_ways());
 
    /* Per L3 Cos create struct */
    l3_cos_vec.resize(l3cos_count);
@@ -816,20 +2108,14 @@ void Pqos::init() {
       // class id
       current_cos.id = l3ca_table[cos].class_id;
       // bit mask
-      std::string bitmask = std::bitset<sizeof(unsigned) * 8>(l3ca_table[cos].u.ways_mask).to_string().substr(sizeof(unsigned) * 8 - get_l3_num_ways());
+      Way_Mask bitmask(l3ca_table[cos].u.ways_mask, get_l3_num_ways());
       current_cos.bitmask = bitmask;
       current_cos.new_bitmask = bitmask;
       // size = num of set bit * way size
-      current_cos.size = std::count_if(bitmask.begin(), bitmask.end(), [&] (char bit) {return bit == '1';}) * get_l3_way_size();
+      current_cos.size = bitmask.count() * get_l3_way_size();
       current_cos.new_size = current_cos.size;
    }
-   // tag
-   get_cos_tags();
-   // process list
-   update_processes_vec();
-
    std::cout << "PQoS Initialisation Success!" << std::endl;
-   std::cout << "PQoS init - starting resource monitoring!" << std::endl;
-   monInitialised = start_resource_monitoring();
+   return true;
 }
 
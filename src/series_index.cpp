@@ -0,0 +1,86 @@
+#include "series_index.hpp"
+
+Series_Index::Series_Index(size_t capacity, size_t _block_size) :
+   block_size(std::max(static_cast<size_t>(1), _block_size)),
+   num_slots(capacity / block_size + 2) // live blocks never share a slot, including two partial ones
+{
+   clear();
+}
+
+void Series_Index::set_leaf(size_t slot, uint64_t min, uint64_t max) {
+   size_t node = slot + num_slots;
+   tree_min[node] = min;
+   tree_max[node] = max;
+   for (node /= 2; node >= 1; node /= 2) {
+      tree_min[node] = std::min(tree_min[2 * node], tree_min[2 * node + 1]);
+      tree_max[node] = std::max(tree_max[2 * node], tree_max[2 * node + 1]);
+   }
+}
+
+void Series_Index::query_slots(size_t from, size_t to, uint64_t& min, uint64_t& max) const {
+   for (from += num_slots, to += num_slots; from < to; from /= 2, to /= 2) {
+      if (from & 1) {
+         min = std::min(min, tree_min[from]);
+         max = std::max(max, tree_max[from++]);
+      }
+      if (to & 1) {
+         min = std::min(min, tree_min[--to]);
+         max = std::max(max, tree_max[to]);
+      }
+   }
+}
+
+void Series_Index::push(uint64_t value) {
+   size_t slot = (num_samples / block_size) % num_slots;
+   if (num_samples % block_size == 0) {
+      set_leaf(slot, value, value); // the slot's previous block was evicted long ago
+   } else {
+      set_leaf(slot, std::min(tree_min[slot + num_slots], value), std::max(tree_max[slot + num_slots], value));
+   }
+   ++num_samples;
+}
+
+void Series_Index::pop_front() {
+   if (first_sample < num_samples) ++first_sample;
+}
+
+void Series_Index::clear() {
+   first_sample = 0;
+   num_samples = 0;
+   tree_min.assign(2 * num_slots, no_value);
+   tree_max.assign(2 * num_slots, 0);
+}
+
+// Min, max and last value of values[first, last), values being the history this index mirrors
+series_span Series_Index::span(const std::vector<uint64_t>& values, size_t first, size_t last) const {
+   series_span result = {no_value, 0, 0};
+   last = std::min(last, values.size());
+   if (first >= last) return result;
+   result.last = values[last - 1];
+
+   auto scan = [&](size_t from, size_t to) {
+      for (size_t i=from; i<to; ++i) {
+         result.min = std::min(result.min, values[i]);
+         result.max = std::max(result.max, values[i]);
+      }
+   };
+   // out of sync (not mirrored), or the range lies within a block or two
+   size_t first_block = (first_sample + first + block_size - 1) / block_size;
+   size_t last_block = (first_sample + last) / block_size;
+   if (values.size() != num_samples - first_sample || first_block >= last_block) {
+      scan(first, last);
+      return result;
+   }
+
+   scan(first, first_block * block_size - first_sample);
+   scan(last_block * block_size - first_sample, last);
+   size_t from = first_block % num_slots;
+   size_t count = last_block - first_block;
+   if (from + count <= num_slots) {
+      query_slots(from, from + count, result.min, result.max);
+   } else {
+      query_slots(from, num_slots, result.min, result.max);
+      query_slots(0, from + count - num_slots, result.min, result.max);
+   }
+   return result;
+}
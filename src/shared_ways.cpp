@@ -0,0 +1,201 @@
+#include "shared_ways.hpp"
+
+using namespace Autotuna;
+
+static const double INF = std::numeric_limits<double>::infinity();
+
+// Cost at a fractional number of ways, linear between measured way counts
+double Autotuna::interpolate_curve(const std::vector<float>& curve, double ways) {
+   if (curve.empty()) return 0.0;
+   if (ways >= curve.size()) return curve.back();
+   if (ways <= 1.0) {
+      // below one way, extend the first segment's slope
+      double slope = curve.size() > 1 ? std::max(0.0f, curve[0] - curve[1]) : 0.0;
+      return curve[0] + (1.0 - ways) * slope;
+   }
+   int lower = static_cast<int>(ways);
+   double fraction = ways - lower;
+   return curve[lower-1] + fraction * (curve[lower] - curve[lower-1]);
+}
+
+/* Contention model for two cos sharing ways
+ * head [aaaaSS]         head_ways = 6, tail_ways = 4, num_shared = 2
+ * tail     [SSbb]
+ * Each cos keeps its exclusive ways and wins a share of the shared ways proportional to
+ * its miss pressure (unweighted misses at its allocation), as misses are what insert lines.
+*/
+double Autotuna::contended_cost(const std::vector<float>& head_curve, const std::vector<float>& tail_curve, float head_weight, float tail_weight, int head_ways, int tail_ways, int num_shared) {
+   double head_pressure = head_curve[head_ways-1] / std::max(head_weight, 1e-6f);
+   double tail_pressure = tail_curve[tail_ways-1] / std::max(tail_weight, 1e-6f);
+   double head_share = (head_pressure + tail_pressure) > 0 ? head_pressure / (head_pressure + tail_pressure) : 0.5;
+
+   double head_effective = (head_ways - num_shared) + num_shared * head_share;
+   double tail_effective = (tail_ways - num_shared) + num_shared * (1.0 - head_share);
+   return interpolate_curve(head_curve, head_effective) + interpolate_curve(tail_curve, tail_effective);
+}
+
+// Only explicitly ranked, low priority cos (rank 1..max_rank) may share ways with each other
+bool Autotuna::compatible_priority(int rank_a, int rank_b, int max_rank) {
+   return rank_a > 0 && rank_b > 0 && rank_a <= max_rank && rank_b <= max_rank;
+}
+
+namespace {
+   struct split {
+      int head_ways;
+      int tail_ways;
+      int num_shared;
+   };
+
+   // A cos, or two cos sharing a contiguous group of ways
+   struct tenant {
+      std::vector<unsigned> members;
+      std::vector<double> cost; // per group width 1..W
+      std::vector<split> splits; // merged tenants only, per group width
+      int min_ways;
+      int max_ways;
+   };
+
+   tenant merge_tenants(const scaled_data& data, const tenant& head, const tenant& tail, int num_ways, int max_shared) {
+      auto index = [&](unsigned cos) { return std::distance(data.order.begin(), std::find(data.order.begin(), data.order.end(), cos)); };
+      const std::vector<float>& head_curve = data.matrix[index(head.members[0])];
+      const std::vector<float>& tail_curve = data.matrix[index(tail.members[0])];
+      float head_weight = data.weights[index(head.members[0])];
+      float tail_weight = data.weights[index(tail.members[0])];
+
+      tenant merged;
+      merged.members = {head.members[0], tail.members[0]};
+      merged.cost.assign(num_ways, INF);
+      merged.splits.assign(num_ways, {0, 0, 0});
+      merged.min_ways = num_ways + 1;
+      merged.max_ways = 0;
+
+      for (int a=head.min_ways; a<=head.max_ways; ++a) {
+         for (int b=tail.min_ways; b<=tail.max_ways; ++b) {
+            int shared_limit = std::min({a - 1, b - 1, max_shared}); // each cos keeps at least one exclusive way
+            for (int s=0; s<=shared_limit; ++s) {
+               int width = a + b - s;
+               if (width > num_ways) continue;
+               double cost = s == 0 ? head.cost[a-1] + tail.cost[b-1]
+                                    : Autotuna::contended_cost(head_curve, tail_curve, head_weight, tail_weight, a, b, s);
+               if (cost < merged.cost[width-1]) {
+                  merged.cost[width-1] = cost;
+                  merged.splits[width-1] = {a, b, s};
+               }
+               merged.min_ways = std::min(merged.min_ways, width);
+               merged.max_ways = std::max(merged.max_ways, width);
+            }
+         }
+      }
+      return merged;
+   }
+
+   tuning_plan solve_tenants(Optimizer& optimizer, const std::vector<tenant>& tenants, int num_ways, const std::map<unsigned, int>& priority_map) {
+      optimizer_problem problem;
+      problem.num_cos = tenants.size();
+      problem.num_ways = num_ways;
+      for (const tenant& t : tenants) {
+         // widths a merged tenant can't take are infinite, they lie outside its min/max ways but would
+         // still turn the optimizer's convexity test into inf - inf
+         double max_cost = 0.0;
+         for (const double& cost : t.cost) if (std::isfinite(cost)) max_cost = std::max(max_cost, cost);
+         for (const double& cost : t.cost) problem.cost.push_back(std::isfinite(cost) ? cost : max_cost);
+         problem.min_ways.push_back(t.min_ways);
+         problem.max_ways.push_back(t.max_ways);
+      }
+
+      tuning_plan plan = {{}, {}, INF};
+      std::vector<allocation> solutions = optimizer.solve(problem, 1);
+      if (solutions.empty()) return plan;
+      plan.cost = solutions[0].cost;
+
+      // ways left by tenants with no misses are handed out as on the disjoint path, ranked tenants in priority order
+      std::vector<int> widths = solutions[0].ways;
+      std::vector<std::pair<int, size_t>> ranked; // rank, tenant
+      for (size_t i=0; i<tenants.size(); ++i) {
+         int rank = -1;
+         for (const unsigned& cos : tenants[i].members) {
+            auto it = priority_map.find(cos);
+            if (it != priority_map.end()) rank = rank == -1 ? it->second : std::min(rank, it->second);
+         }
+         if (rank != -1) ranked.push_back({rank, i});
+      }
+      std::stable_sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+      int leftover = num_ways;
+      for (const int& width : widths) leftover -= width;
+      if (leftover > 0 && !ranked.empty()) {
+         std::vector<int> ranked_widths, ranked_max_ways;
+         for (const auto& [rank, i] : ranked) {
+            ranked_widths.push_back(widths[i]);
+            ranked_max_ways.push_back(tenants[i].max_ways);
+         }
+         distribute_leftover_ways(ranked_widths, ranked_max_ways, leftover);
+         for (size_t k=0; k<ranked.size(); ++k) widths[ranked[k].second] = ranked_widths[k];
+      }
+
+      for (size_t i=0; i<tenants.size(); ++i) {
+         const tenant& t = tenants[i];
+         int width = widths[i];
+         if (t.members.size() == 1) {
+            plan.ways_map[t.members[0]] = width;
+         } else {
+            const split& sp = t.splits[width-1];
+            plan.ways_map[t.members[0]] = sp.head_ways;
+            plan.ways_map[t.members[1]] = sp.tail_ways;
+            if (sp.num_shared > 0) plan.overlaps.push_back({t.members[0], t.members[1], sp.num_shared});
+         }
+      }
+      return plan;
+   }
+}
+
+// Greedily merge the pair of compatible cos whose sharing lowers the predicted cost the most,
+// until no further pair helps. The best overlapping plan, if any, is put in front of the disjoint plans.
+std::vector<tuning_plan> Autotuna::consider_shared_ways(Optimizer& optimizer, const scaled_data& data, const ways_limits& limits, const std::map<unsigned, int>& priority_map, int max_rank, int max_shared, const std::vector<tuning_plan>& plans) {
+   if (plans.empty() || max_rank < 1 || max_shared < 1 || data.matrix.empty()) return plans;
+
+   int num_ways = data.matrix[0].size();
+   std::vector<tenant> tenants;
+   for (size_t i=0; i<data.order.size(); ++i) {
+      unsigned cos = data.order[i];
+      tenant t;
+      t.members = {cos};
+      t.cost.assign(data.matrix[i].begin(), data.matrix[i].end());
+      t.min_ways = std::clamp(limits.min_ways.at(cos), 1, num_ways);
+      t.max_ways = std::clamp(limits.max_ways.at(cos), t.min_ways, num_ways);
+      tenants.push_back(t);
+   }
+
+   auto rank = [&](unsigned cos) { auto it = priority_map.find(cos); return it == priority_map.end() ? 0 : it->second; };
+
+   tuning_plan best = plans[0];
+   bool improved = true;
+   while (improved) {
+      improved = false;
+      std::vector<tenant> best_tenants;
+      for (size_t i=0; i<tenants.size(); ++i) {
+         for (size_t j=0; j<tenants.size(); ++j) {
+            if (i == j || tenants[i].members.size() > 1 || tenants[j].members.size() > 1) continue;
+            if (!compatible_priority(rank(tenants[i].members[0]), rank(tenants[j].members[0]), max_rank)) continue;
+
+            std::vector<tenant> candidate;
+            for (size_t k=0; k<tenants.size(); ++k) {
+               if (k != i && k != j) candidate.push_back(tenants[k]);
+            }
+            candidate.push_back(merge_tenants(data, tenants[i], tenants[j], num_ways, max_shared));
+            tuning_plan plan = solve_tenants(optimizer, candidate, num_ways, priority_map);
+            if (!plan.overlaps.empty() && plan.cost < best.cost) {
+               best = plan;
+               best_tenants = candidate;
+               improved = true;
+            }
+         }
+      }
+      if (improved) tenants = best_tenants;
+   }
+
+   if (best.overlaps.empty()) return plans;
+   std::vector<tuning_plan> result = {best};
+   result.insert(result.end(), plans.begin(), plans.end());
+   if (result.size() > plans.size()) result.pop_back(); // keep the requested number of alternatives
+   return result;
+}
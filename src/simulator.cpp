@@ -0,0 +1,81 @@
+#include "simulator.hpp"
+
+using namespace Autotuna;
+
+/* Predict each cos' misses, occupancy and cost for a candidate set of bitmasks
+ * A way used by several cos is split between them in proportion to their miss pressure
+ * (their curve's misses at their own number of ways), the same contention model AutoTuna
+ * uses when it considers shared ways. Misses are read off the measured curve at the
+ * resulting effective ways, occupancy is the cos' current demand capped by those ways.
+*/
+configuration_prediction Autotuna::predict_configuration(const std::map<unsigned, Way_Mask>& bitmasks, const std::map<unsigned, std::vector<uint64_t>>& curves, const std::map<unsigned, int>& priority_map, const std::map<unsigned, uint64_t>& demand, unsigned way_size, uint64_t threshold) {
+   configuration_prediction prediction = {{}, 0.0, {}};
+
+   std::map<unsigned, double> pressure;
+   std::map<unsigned, int> num_ways;
+   for (const auto&[cos, bitmask] : bitmasks) {
+      num_ways[cos] = bitmask.count();
+      auto curve = curves.find(cos);
+      if (curve == curves.end() || curve->second.empty() || num_ways[cos] == 0) continue;
+      pressure[cos] = curve->second[std::min(static_cast<size_t>(num_ways[cos]), curve->second.size()) - 1];
+   }
+
+   // effective ways per cos
+   std::map<unsigned, double> effective_ways;
+   unsigned l3_num_ways = bitmasks.empty() ? 0 : bitmasks.begin()->second.get_num_ways();
+   for (unsigned way=0; way<l3_num_ways; ++way) {
+      std::vector<unsigned> users;
+      double total_pressure = 0;
+      for (const auto&[cos, bitmask] : bitmasks) {
+         if (!bitmask.test(way)) continue;
+         users.push_back(cos);
+         total_pressure += pressure.count(cos) ? pressure[cos] : 0.0;
+      }
+      for (const unsigned& cos : users) {
+         double own = pressure.count(cos) ? pressure[cos] : 0.0;
+         effective_ways[cos] += total_pressure > 0 ? own / total_pressure : 1.0 / users.size();
+      }
+   }
+
+   for (const auto&[cos, bitmask] : bitmasks) {
+      cos_prediction cos_pred = {cos, false, num_ways[cos], effective_ways[cos], 0.0, 0, 0.0};
+      auto curve = curves.find(cos);
+      if (curve != curves.end() && !curve->second.empty()) {
+         std::vector<float> curve_f(curve->second.begin(), curve->second.end());
+         auto rank = priority_map.find(cos);
+         float weight = normalise_priority_ranking(rank == priority_map.end() ? 0 : rank->second, priority_map);
+         cos_pred.has_curve = true;
+         cos_pred.misses = cos_pred.num_ways == 0 ? curve->second[0] : interpolate_curve(curve_f, cos_pred.effective_ways);
+         cos_pred.cost = weight * cos_pred.misses;
+         prediction.cost += cos_pred.cost;
+      }
+      auto cos_demand = demand.find(cos);
+      uint64_t capacity = static_cast<uint64_t>(cos_pred.effective_ways * way_size);
+      cos_pred.occupancy = cos_demand == demand.end() ? capacity : std::min(cos_demand->second, capacity);
+
+      // structural problems are caught regardless of curves
+      if (cos_pred.num_ways == 0) prediction.warnings.push_back("Cos " + std::to_string(cos) + " has no cache ways");
+      else if (!bitmask.is_contiguous()) prediction.warnings.push_back("Cos " + std::to_string(cos) + " bitmask is not contiguous");
+      else if (bitmask.get_num_ways() >= 2 && bitmask.test(0) != bitmask.test(1)) prediction.warnings.push_back("Cos " + std::to_string(cos) + " splits the DDIO ways");
+      if (cos_pred.has_curve && cos_pred.misses >= threshold) prediction.warnings.push_back("Cos " + std::to_string(cos) + " predicted above misses threshold");
+
+      prediction.cos_predictions.push_back(cos_pred);
+   }
+   return prediction;
+}
+
+// Flag what makes a candidate worse than the live configuration
+std::vector<std::string> Autotuna::compare_predictions(const configuration_prediction& live, const configuration_prediction& candidate, uint64_t threshold, double max_cost_increase) {
+   std::vector<std::string> warnings;
+   for (const cos_prediction& cand : candidate.cos_predictions) {
+      auto now = std::find_if(live.cos_predictions.begin(), live.cos_predictions.end(), [&](const cos_prediction& p) { return p.cos == cand.cos; });
+      if (now == live.cos_predictions.end() || !now->has_curve || !cand.has_curve) continue;
+      if (now->misses < threshold && cand.misses >= threshold) {
+         warnings.push_back("Cos " + std::to_string(cand.cos) + " would cross the misses threshold");
+      }
+   }
+   if (live.cost > 0 && candidate.cost > live.cost * (1.0 + max_cost_increase)) {
+      warnings.push_back("Predicted cost rises by " + std::to_string(static_cast<int>((candidate.cost / live.cost - 1.0) * 100)) + "%");
+   }
+   return warnings;
+}
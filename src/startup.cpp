@@ -0,0 +1,79 @@
+#include "startup.hpp"
+
+Startup_Graph::Startup_Graph(const std::string& _log_path) :
+   created(std::chrono::steady_clock::now()),
+   log_path(_log_path)
+{
+   std::ofstream outfile(log_path, std::ios::out | std::ios::trunc);
+}
+
+double Startup_Graph::get_elapsed() {
+   return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - created).count();
+}
+
+/* Log line layout
+ * <stage> start=<ms> duration=<ms> <ok|failed|skipped>
+*/
+void Startup_Graph::record(const stage_timing& timing) {
+   std::lock_guard<std::mutex> lock(mutex);
+   timings.push_back(timing);
+   std::ofstream outfile(log_path, std::ios::out | std::ios::app);
+   if (!outfile.is_open()) return;
+   outfile << std::fixed << std::setprecision(1) << timing.name << " start=" << timing.start << " duration=" << timing.duration
+           << " " << (timing.skipped ? "skipped" : timing.succeeded ? "ok" : "failed") << "\n";
+}
+
+void Startup_Graph::add_stage(const std::string& name, const std::vector<std::string>& dependencies, const std::function<bool()>& stage) {
+   std::lock_guard<std::mutex> lock(mutex);
+   std::vector<std::shared_future<bool>> waits;
+   for (const std::string& dependency : dependencies) {
+      auto found = stages.find(dependency);
+      if (found != stages.end()) waits.push_back(found->second);
+   }
+   stages[name] = std::async(std::launch::async, [this, name, waits, stage] {
+      bool ready = true;
+      for (const auto& dependency : waits) ready = dependency.get() && ready;
+      double start = get_elapsed();
+      bool succeeded = ready && stage();
+      record({name, start, get_elapsed() - start, succeeded, !ready});
+      return succeeded;
+   }).share();
+}
+
+// Blocks until the stage finished, false if it failed, was skipped or doesn't exist
+bool Startup_Graph::wait(const std::string& name) {
+   std::shared_future<bool> stage;
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found = stages.find(name);
+      if (found == stages.end()) return false;
+      stage = found->second;
+   }
+   return stage.get();
+}
+
+void Startup_Graph::wait_all() {
+   std::vector<std::shared_future<bool>> pending;
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto&[name, stage] : stages) pending.push_back(stage);
+   }
+   for (const auto& stage : pending) stage.wait();
+}
+
+// Finished successfully, without blocking
+bool Startup_Graph::is_done(const std::string& name) {
+   std::shared_future<bool> stage;
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found = stages.find(name);
+      if (found == stages.end()) return false;
+      stage = found->second;
+   }
+   return stage.wait_for(std::chrono::seconds(0)) == std::future_status::ready && stage.get();
+}
+
+std::vector<stage_timing> Startup_Graph::get_timings() {
+   std::lock_guard<std::mutex> lock(mutex);
+   return timings;
+}
@@ -0,0 +1,140 @@
+#include "topology.hpp"
+
+using namespace Topology;
+
+namespace {
+   std::string read_line(const std::string& file_path) {
+      std::ifstream infile(file_path);
+      std::string line;
+      std::getline(infile, line);
+      return line;
+   }
+
+   int read_int(const std::string& file_path, int default_val) {
+      std::string line = read_line(file_path);
+      if (line.empty() || !std::all_of(line.begin(), line.end(), ::isdigit)) return default_val;
+      return std::stoi(line);
+   }
+
+   std::string trim(const std::string& str) {
+      size_t first = str.find_first_not_of(" \t");
+      if (first == std::string::npos) return "";
+      return str.substr(first, str.find_last_not_of(" \t\n") - first + 1);
+   }
+
+   // Vendor and brand string from CPUID, /proc/cpuinfo elsewhere
+   void read_cpuid(cpu_topology& topology) {
+#if defined(__x86_64__) || defined(__i386__)
+      unsigned regs[4];
+      if (__get_cpuid(0, &regs[0], &regs[1], &regs[2], &regs[3])) {
+         char vendor[13] = {};
+         std::memcpy(vendor, &regs[1], 4);
+         std::memcpy(vendor + 4, &regs[3], 4);
+         std::memcpy(vendor + 8, &regs[2], 4);
+         topology.vendor = vendor;
+      }
+      if (__get_cpuid(0x80000000, &regs[0], &regs[1], &regs[2], &regs[3]) && regs[0] >= 0x80000004) {
+         char brand[49] = {};
+         for (unsigned leaf=0; leaf<3; ++leaf) {
+            __get_cpuid(0x80000002 + leaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+            std::memcpy(brand + 16 * leaf, regs, 16);
+         }
+         topology.model_name = trim(brand);
+      }
+#endif
+      if (!topology.model_name.empty()) return;
+      std::ifstream cpuinfo("/proc/cpuinfo");
+      std::string line;
+      while (std::getline(cpuinfo, line)) {
+         if (line.rfind("model name", 0) != 0 || line.find(':') == std::string::npos) continue;
+         topology.model_name = trim(line.substr(line.find(':') + 1));
+         break;
+      }
+   }
+}
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}, the inverse of Misc::to_range_extraction
+std::set<int> Topology::parse_cpu_list(const std::string& list) {
+   std::set<int> cpus;
+   std::istringstream iss(list);
+   std::string range;
+   while (std::getline(iss, range, ',')) {
+      range = trim(range);
+      if (range.empty() || !std::isdigit(range[0])) continue;
+      size_t dash = range.find('-');
+      int first = std::stoi(range);
+      int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu=first; cpu<=last; ++cpu) cpus.insert(cpu);
+   }
+   return cpus;
+}
+
+cpu_topology Topology::read(const std::string& sys_root) {
+   cpu_topology topology = {"", "", "", {}, {}, {}, {}, 1, 1};
+   read_cpuid(topology);
+   struct utsname name;
+   if (uname(&name) == 0) topology.architecture = name.machine;
+
+   for (const int& cpu : parse_cpu_list(read_line(sys_root + "cpu/online"))) {
+      std::string cpu_path = sys_root + "cpu/cpu" + std::to_string(cpu) + "/";
+      cpu_thread thread = {read_int(cpu_path + "topology/core_id", cpu), read_int(cpu_path + "topology/physical_package_id", 0), -1, -1,
+                           parse_cpu_list(read_line(cpu_path + "topology/thread_siblings_list"))};
+      if (thread.siblings.empty()) thread.siblings.insert(cpu);
+
+      // the cache index of the L3 differs between cpu models
+      for (int index=0; ; ++index) {
+         std::string index_path = cpu_path + "cache/index" + std::to_string(index) + "/";
+         int level = read_int(index_path + "level", -1);
+         if (level < 0) break;
+         if (level != 3) continue;
+         std::set<int> shared = parse_cpu_list(read_line(index_path + "shared_cpu_list"));
+         thread.l3_domain = read_int(index_path + "id", shared.empty() ? cpu : *shared.begin());
+         break;
+      }
+      topology.cpus[cpu] = thread;
+      topology.sockets[thread.socket].insert(cpu);
+      if (thread.l3_domain >= 0) topology.l3_domains[thread.l3_domain].insert(cpu);
+      topology.threads_per_core = std::max(topology.threads_per_core, static_cast<int>(thread.siblings.size()));
+   }
+
+   for (const int& node : parse_cpu_list(read_line(sys_root + "node/online"))) {
+      std::set<int> cpus = parse_cpu_list(read_line(sys_root + "node/node" + std::to_string(node) + "/cpulist"));
+      for (const int& cpu : cpus) {
+         if (topology.cpus.count(cpu)) topology.cpus[cpu].numa_node = node;
+      }
+      if (!cpus.empty()) topology.numa_nodes[node] = cpus;
+   }
+
+   std::set<std::pair<int, int>> cores;
+   for (const auto&[cpu, thread] : topology.cpus) cores.insert({thread.socket, thread.core_id});
+   if (!topology.sockets.empty()) topology.cores_per_socket = std::max(1, static_cast<int>(cores.size() / topology.sockets.size()));
+   return topology;
+}
+
+// Read once, the topology doesn't change while CacheTuna runs
+const cpu_topology& Topology::get() {
+   static const cpu_topology topology = read();
+   return topology;
+}
+
+// lscpu like summary for the info box
+std::vector<std::string> Topology::describe(const cpu_topology& topology) {
+   std::vector<std::string> lines;
+   auto add_line = [&](const std::string& key, const std::string& value) {
+      std::ostringstream line;
+      line << std::setw(22) << std::left << key + ":" << value;
+      lines.push_back(line.str());
+   };
+   add_line("Architecture", topology.architecture);
+   add_line("CPU(s)", std::to_string(topology.cpus.size()));
+   add_line("Model name", topology.model_name);
+   add_line("Thread(s) per core", std::to_string(topology.threads_per_core));
+   add_line("Core(s) per socket", std::to_string(topology.cores_per_socket));
+   add_line("Socket(s)", std::to_string(topology.sockets.size()));
+   add_line("L3 domain(s)", std::to_string(topology.l3_domains.size()));
+   add_line("NUMA node(s)", std::to_string(topology.numa_nodes.size()));
+   for (const auto&[node, cpus] : topology.numa_nodes) {
+      add_line("NUMA node" + std::to_string(node) + " CPU(s)", Misc::to_range_extraction(cpus));
+   }
+   return lines;
+}
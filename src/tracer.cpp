@@ -0,0 +1,157 @@
+#include "tracer.hpp"
+
+using namespace Tracer;
+
+namespace {
+   const size_t chunk_events = 4096; // buffers grow a chunk at a time, up to the capacity
+
+   struct thread_buffer {
+      int tid;
+      std::string name;          // set_thread_name's name, threads of the same name take turns on a buffer
+      std::string thread_name;   // the track's name, guarded by registry_mutex
+      bool in_use;               // guarded by registry_mutex, false once its thread exited
+      std::vector<std::unique_ptr<event[]>> chunks; // slots sized once, each chunk allocated by the owning thread
+      std::atomic<size_t> size{0};
+      std::atomic<uint64_t> dropped{0};
+   };
+
+   std::atomic<bool> enabled{false};
+   bool started = false; // a trace is recorded once per run, buffers live until exit
+   std::mutex registry_mutex;
+   std::vector<std::unique_ptr<thread_buffer>> buffers;
+   std::string trace_path;
+   size_t capacity = 0;
+   std::chrono::steady_clock::time_point start_time;
+   thread_local std::string pending_thread_name;
+
+   // Hands the thread's buffer back when the thread exits, e.g. each analysis runs on new threads
+   struct buffer_lease {
+      thread_buffer* buffer = nullptr;
+      ~buffer_lease() {
+         if (buffer == nullptr) return;
+         std::lock_guard<std::mutex> lock(registry_mutex);
+         buffer->in_use = false;
+      }
+   };
+   thread_local buffer_lease lease;
+
+   // The calling thread's buffer, taken over from an exited thread of the same name or registered on its first event
+   thread_buffer* get_buffer() {
+      if (lease.buffer != nullptr) return lease.buffer;
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      if (!enabled) return nullptr;
+      int num_named = 0;
+      for (const auto& buffer : buffers) {
+         if (pending_thread_name.empty() || buffer->name != pending_thread_name) continue;
+         if (!buffer->in_use) {
+            buffer->in_use = true;
+            lease.buffer = buffer.get();
+            return lease.buffer;
+         }
+         ++num_named;
+      }
+      buffers.push_back(std::make_unique<thread_buffer>());
+      thread_buffer* buffer = buffers.back().get();
+      buffer->tid = static_cast<int>(buffers.size());
+      buffer->name = pending_thread_name;
+      if (pending_thread_name.empty()) buffer->thread_name = "thread " + std::to_string(buffer->tid);
+      else buffer->thread_name = num_named == 0 ? pending_thread_name : pending_thread_name + " " + std::to_string(num_named + 1);
+      buffer->in_use = true;
+      buffer->chunks.resize((capacity + chunk_events - 1) / chunk_events);
+      lease.buffer = buffer;
+      return buffer;
+   }
+
+   void append(const char* name, char phase, int cos, double value) {
+      uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+      thread_buffer* buffer = get_buffer();
+      if (buffer == nullptr) return;
+      size_t size = buffer->size.load(std::memory_order_relaxed);
+      if (size >= capacity) {
+         buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+         return;
+      }
+      std::unique_ptr<event[]>& chunk = buffer->chunks[size / chunk_events];
+      if (!chunk) {
+         chunk.reset(new (std::nothrow) event[chunk_events]);
+         if (!chunk) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+         }
+      }
+      chunk[size % chunk_events] = {ts, name, phase, cos, value};
+      buffer->size.store(size + 1, std::memory_order_release);
+   }
+}
+
+bool Tracer::is_enabled() {
+   return enabled.load(std::memory_order_relaxed);
+}
+
+// Record events until stop() writes them to path, buffer_events per thread
+bool Tracer::start(const std::string& path, size_t buffer_events) {
+   std::lock_guard<std::mutex> lock(registry_mutex);
+   if (started || path.empty() || buffer_events == 0) return false;
+   started = true;
+   trace_path = path;
+   capacity = buffer_events;
+   start_time = std::chrono::steady_clock::now();
+   enabled = true;
+   return true;
+}
+
+void Tracer::set_thread_name(const std::string& name) {
+   pending_thread_name = name;
+   if (!is_enabled()) return;
+   thread_buffer* buffer = get_buffer();
+   if (buffer == nullptr) return;
+   std::lock_guard<std::mutex> lock(registry_mutex);
+   if (buffer->name == name) return;
+   buffer->name = name; // renamed after its first event
+   buffer->thread_name = name;
+}
+
+void Tracer::begin(const char* name, int cos) {
+   if (is_enabled()) append(name, 'B', cos, 0);
+}
+
+void Tracer::end(const char* name) {
+   if (is_enabled()) append(name, 'E', -1, 0);
+}
+
+void Tracer::counter(const char* name, int cos, double value) {
+   if (is_enabled()) append(name, 'C', cos, value);
+}
+
+/* Stops recording and writes the Chrome JSON object format: one metadata event naming each thread, then its events.
+ * Counters become one track per cos and metric ("Cos 3 misses"), spans about a cos carry it as an argument.
+*/
+bool Tracer::stop() {
+   if (!enabled.exchange(false)) return false;
+   std::lock_guard<std::mutex> lock(registry_mutex);
+   std::ofstream file(trace_path, std::ios::out | std::ios::trunc);
+   if (!file.is_open()) return false;
+
+   int pid = static_cast<int>(getpid());
+   uint64_t dropped = 0;
+   bool first = true;
+   file << "{\"traceEvents\":[\n" << std::fixed << std::setprecision(3);
+   for (const auto& buffer : buffers) {
+      dropped += buffer->dropped.load(std::memory_order_relaxed);
+      file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+           << ",\"args\":{\"name\":\"" << buffer->thread_name << "\"}}";
+      first = false;
+      size_t size = buffer->size.load(std::memory_order_acquire);
+      for (size_t i=0; i<size; ++i) {
+         const event& e = buffer->chunks[i / chunk_events][i % chunk_events];
+         file << ",\n{\"name\":\"";
+         if (e.phase == 'C') file << "Cos " << e.cos << " ";
+         file << e.name << "\",\"ph\":\"" << e.phase << "\",\"pid\":" << pid << ",\"tid\":" << buffer->tid << ",\"ts\":" << e.ts / 1000.0;
+         if (e.phase == 'C') file << ",\"args\":{\"value\":" << e.value << "}";
+         else if (e.cos >= 0) file << ",\"args\":{\"cos\":" << e.cos << "}";
+         file << "}";
+      }
+   }
+   file << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+   return static_cast<bool>(file);
+}
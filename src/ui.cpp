@@ -8,35 +8,67 @@ UserInterface::UserInterface():
    tab_selected(0),
    bit_selected(0),
    core_selected(0),
+   core_range_anchor(-1),
    process_selected(0),
    autotuna_cos_selected(0),
    threshold(10),
    root_cos(-1),
    priority_cos_selected(0),
+   line_plot_visible(0),
    stop_poll_data(false),
    tuning_feasible(false),
+   phase_reanalysis(false),
    frame_count(0),
+   refresh_pending(false),
+   data_version(0),
+   config_version(0),
+   frame_dimx(0),
+   frame_dimy(0),
+   frame_time_last(0),
+   frame_time_average(0),
+   num_frames(0),
    button_style(ButtonOption::Animated()),
-   pqos(Pqos())
+   pqos(Pqos()),
+   startup(Misc::get_executable_path() + "startup.log")
 {
-   pqos.init();
+   pqos.init(startup);
    std::ifstream exit_file(Misc::get_executable_path() + "unexpected_exit.conf");
    unexpected_exit = exit_file.good();
-   if (!unexpected_exit) pqos.backup_config("unexpected_exit.conf");
+   startup.add_stage("cpu_info", {}, [this] {
+      cpu_info = Topology::describe(Topology::get());
+      return true;
+   });
+   startup.add_stage("exit_backup", {"tags"}, [this] {
+      if (!unexpected_exit) pqos.backup_config("unexpected_exit.conf");
+      return true;
+   });
+   // the first frame only needs the topology, the other panels fill in as their stages finish
+   startup.wait("settings");
+   startup.wait("topology");
+   show_frame_time = pqos.get_setting("SHOW_FRAME_TIME", 0) != 0;
+   std::string trace_file = pqos.get_setting_string("TRACE_FILE", "");
+   if (!trace_file.empty()) {
+      if (trace_file[0] != '/') trace_file = Misc::get_executable_path() + trace_file;
+      // a negative or out of range size would wrap around as a size_t
+      double buffer_events = pqos.get_setting("TRACE_BUFFER_EVENTS", 262144);
+      if (!(buffer_events >= 1 && buffer_events <= 1e9)) buffer_events = 262144;
+      Tracer::start(trace_file, static_cast<size_t>(buffer_events));
+   }
 }
 
 Component UserInterface::get_tab_toggle() {
-   tab_values = {"CacheTuna", "AutoTuna"};
+   tab_values = {"CacheTuna", "AutoTuna", "Diagnostics"};
    return Toggle(&tab_values, &tab_selected);
 }
 
 Element UserInterface::cpu_cache_info_hbox() {
    // CPU info
-   std::vector<std::string> cpu_info = Misc::get_cpu_info();
    Elements cpu_info_elements;
-
-   for (const auto& line : cpu_info) {
-      cpu_info_elements.push_back(text(" " + line));
+   if (!startup.is_done("cpu_info")) cpu_info_elements.push_back(text(" Loading . . .") | color(Color::GrayDark));
+   else {
+      for (const auto& line : cpu_info) {
+         cpu_info_elements.push_back(text(" " + line));
+      }
    }
 
    Element cpu_info_box = vbox({
@@ -179,7 +211,7 @@ Element UserInterface::l3cos_menu_options_boxes(bool tab_focused) {
                      separatorEmpty(),
                      vbox({
                            text(tag),
-                           text(cos.bitmask),
+                           text(cos.bitmask.to_binary() + " (" + cos.bitmask.to_hex() + ")"),
                            text(Misc::format_bytes(cos.size)),
                            text(Misc::to_range_extraction(cos.cores)),
                            }) | xflex_grow
@@ -349,20 +381,28 @@ Element UserInterface::bitmask_window(bool focused) {
       return color(highlight);
    };
 
-   std::string bitmask = pqos.get_l3_cos_vec()[cos_selected].new_bitmask;
+   Way_Mask bitmask = pqos.get_new_bitmask(cos_selected);
+   // ways used by more than one cos with cores, Cos0 aside
+   Way_Mask used(0, bitmask.get_num_ways()), shared(0, bitmask.get_num_ways());
+   std::map<unsigned, Way_Mask> new_bitmasks = pqos.get_new_bitmasks();
+   for (const auto&[cos, cos_bitmask] : new_bitmasks) {
+      if (cos == 0) continue;
+      shared |= used & cos_bitmask;
+      used |= cos_bitmask;
+   }
+   bool has_cores = new_bitmasks.count(cos_selected) > 0;
 
    std::vector<Element> bitmask_texts;
    bool overlap = false;
 
-   for (size_t i=0; i<bitmask.size(); ++i) {
-      std::set<int> bit_assoc = pqos.get_bit_assoc(i);
-      std::string symbol = bitmask[i] == '1' ? "▣" : "☐";
+   for (unsigned i=0; i<bitmask.get_num_ways(); ++i) {
+      std::string symbol = bitmask.test(i) ? "▣" : "☐";
 
       bitmask_texts.push_back(text(symbol));
 
       int state = 0;
       if (focused && bit_selected == i) ++state; // check if bit selected
-      if (cos_selected != 0 && bitmask[i] == '1' && pqos.get_l3_cos_vec()[cos_selected].new_cores.size() > 0 && bit_assoc.size() > 1 ) {
+      if (cos_selected != 0 && bitmask.test(i) && has_cores && shared.test(i)) {
          state += 10;
          overlap = true;
       }
@@ -373,7 +413,7 @@ Element UserInterface::bitmask_window(bool focused) {
 
    // Validity Check
    // Error - Non-contiguous
-   if (Misc::not_contiguous(bitmask)) {
+   if (!bitmask.is_contiguous()) {
       Element error = text(" ERROR: not contiguous");
       error |= color(Color::Red);
       bitmask_box.push_back(error);
@@ -390,10 +430,21 @@ Element UserInterface::bitmask_window(bool focused) {
 }
 
 Element UserInterface::cores_window(bool focused) {
+   // socket and SMT siblings of a core, pinning siblings to different cos makes them share a core's L1/L2
+   const Topology::cpu_topology& topology = Topology::get();
+   auto core_location = [&](int core) -> Element {
+      auto thread = topology.cpus.find(core);
+      if (thread == topology.cpus.end()) return emptyElement();
+      std::set<int> siblings = thread->second.siblings;
+      siblings.erase(core);
+      std::string location = " S" + std::to_string(thread->second.socket);
+      if (!siblings.empty()) location += " SMT " + Misc::to_range_extraction(siblings);
+      return text(location) | color(Color::GrayDark);
+   };
    auto core_text = [&](int core) -> Element {
       unsigned cos = pqos.get_core_assoc(core);
-      if (cos == cos_selected) return text(" ▣ Core " + std::to_string(core));
-      if (cos == 0) return text(" ☐ Core " + std::to_string(core)); // core pinned to Cos0 (default) if not pinned to any active cos
+      if (cos == cos_selected) return hbox({text(" ▣ Core " + std::to_string(core)), core_location(core)});
+      if (cos == 0) return hbox({text(" ☐ Core " + std::to_string(core)), core_location(core)}); // core pinned to Cos0 (default) if not pinned to any active cos
       else return text(" Core " + std::to_string(core) + " - Used by Cos " + std::to_string(cos)) | color(Color::GrayDark);
 
    };
@@ -420,6 +471,9 @@ Element UserInterface::cores_window(bool focused) {
 
    for (size_t i=start; i<=end; ++i) {
       cores_texts.push_back(core_text(i));
+      if (core_range_anchor >= 0 && std::min<int>(core_range_anchor, core_selected) <= int(i) && int(i) <= std::max<int>(core_range_anchor, core_selected)) {
+         cores_texts.back() |= underlined;
+      }
    }
 
    if (focused) {
@@ -430,6 +484,10 @@ Element UserInterface::cores_window(bool focused) {
          cores_texts[index] |= bgcolor(Color::GrayLight);
       }
    }
+
+   for (const auto&[neighbour, shared] : pqos.get_smt_conflicts(cos_selected, threshold * 1000)) {
+      cores_texts.push_back(text(" Warning: core " + Misc::to_range_extraction(shared) + " shares SMT siblings with noisy Cos " + std::to_string(neighbour)) | color(Color::Red));
+   }
          
    return window(text("Cores"), vbox({std::move(cores_texts)}));
 }
@@ -499,11 +557,68 @@ Element UserInterface::processes_list(bool focused) {
    return vbox({std::move(process_texts)}) | size(WIDTH, EQUAL, int(Terminal::Size().dimx * 0.4));
 }
 
+/* Reuse a panel's element while its key (data/config versions and the UI state it shows) is unchanged
+ * Panels are rebuilt at most once per poll, or on the key presses that change what they show.
+*/
+Element UserInterface::memoise(const std::string& panel, const std::vector<uint64_t>& key, const std::function<Element()>& render) {
+   panel_cache& cache = panel_caches[panel];
+   if (!cache.element || cache.key != key) {
+      cache.key = key;
+      cache.element = render();
+   }
+   return cache.element;
+}
+
+Element UserInterface::line_plot(Graph& graph, const std::string& panel, bool misses) {
+   plot_view view = graph.get_view(line_plot_window);
+   line_plot_visible = view.span;
+   return memoise(panel, {data_version, config_version, view.span, view.offset, view.columns}, [&] {
+         return graph.get_graph(pqos.get_plot_series(misses, view), view);
+         });
+}
+
+void UserInterface::record_frame_time(double milliseconds) {
+   frame_time_last = milliseconds;
+   frame_time_average = num_frames == 0 ? milliseconds : 0.9 * frame_time_average + 0.1 * milliseconds;
+   frame_times.push_back(milliseconds);
+   Latency::record(Latency::frame_render, static_cast<uint64_t>(milliseconds * 1e6));
+   if (frame_times.size() > 100) frame_times.pop_front();
+   ++num_frames;
+}
+
+// Build time of the document, the last frame, its moving average and the peak of the last 100 frames
+std::string UserInterface::get_frame_time_summary() {
+   if (frame_times.empty()) return "";
+   std::ostringstream summary;
+   summary << std::fixed << std::setprecision(2) << "frame " << frame_time_last << " ms, avg " << frame_time_average
+           << " ms, peak " << *std::max_element(frame_times.begin(), frame_times.end()) << " ms (" << num_frames << " frames)";
+   return summary.str();
+}
+
 void UserInterface::poll_data(ScreenInteractive &screen) {
+   Tracer::set_thread_name("poll");
+   startup.wait("monitoring");
    while (pqos.monInitialised && pqos.run_thread) {
       std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+      Tracer::Span span("poll_tick");
       pqos.poll_mon_group();
-      screen.PostEvent(Event::Custom);
+      pqos.step_continuous_tuning(threshold * 1000, root_cos);
+      pqos.step_online_search(threshold * 1000, root_cos);
+      if (!phase_reanalysis && pqos.step_phase_tuning(phase_targets)) phase_reanalysis = true;
+      int experiment_retval = pqos.step_experiment(threshold * 1000);
+      if (experiment_retval > 0) {
+         save_error_code = experiment_retval;
+         depth = 2;
+      }
+      int canary_retval = pqos.step_canary(threshold * 1000);
+      if (canary_retval == PQOS_RETVAL_OK) {
+         if (!unexpected_exit) pqos.backup_config("unexpected_exit.conf");
+      } else if (canary_retval > 0) {
+         save_error_code = canary_retval;
+         depth = 2;
+      }
+      // coalesce: a refresh still waiting to be rendered covers this one
+      if (!refresh_pending.exchange(true)) screen.PostEvent(Event::Custom);
    }
 }
 
@@ -526,6 +641,18 @@ Component UserInterface::get_save_options_menu() {
       return;
    };
 
+   auto canary_apply_changes = [&] {
+      update_depth(pqos.start_canary(threshold * 1000), depth, save_error_code);
+      return;
+   };
+
+   std::string experiment_a = pqos.get_setting_string("EXPERIMENT_A", "");
+   std::string experiment_b = pqos.get_setting_string("EXPERIMENT_B", "");
+   auto run_experiment = [&, experiment_a, experiment_b] {
+      update_depth(pqos.start_experiment(experiment_a, experiment_b), depth, save_error_code);
+      return;
+   };
+
    auto load_backup_config = [&] {
       update_depth(pqos.load_config("backup.conf"), depth, save_error_code);
       return;
@@ -538,17 +665,19 @@ Component UserInterface::get_save_options_menu() {
 
    Components buttons;
    buttons.push_back(Button("Apply and Save Changes", apply_and_save_changes, button_style));
+   buttons.push_back(Button("Trial Apply (Canary)", canary_apply_changes, button_style));
 
    std::ifstream backup_file(Misc::get_executable_path() + "backup.conf");
    if (backup_file.good()) buttons.push_back(Button("Load Backup Config", load_backup_config, button_style));
    if (unexpected_exit) buttons.push_back(Button("Load Unexpected Exit Backup Config", load_unexpected_exit_backup_config, button_style));
+   if (!experiment_a.empty() && !experiment_b.empty()) buttons.push_back(Button("Run A/B Experiment (" + experiment_a + " vs " + experiment_b + ")", run_experiment, button_style));
    buttons.push_back(Button("Back", [&] {depth=0;}, button_style));
    return Container::Vertical({std::move(buttons)});
 }
 
 Component UserInterface::get_analyse_options_menu() {
    auto process_autotuna_analysis = [&] {
-      threads.push_back(std::thread(&Pqos::process_autotuna_analysis, std::ref(pqos), threshold, root_cos, std::ref(tuning_feasible), std::ref(depth), std::ref(save_error_code)));
+      threads.push_back(std::thread(&Pqos::process_autotuna_analysis, std::ref(pqos), threshold, root_cos, std::ref(tuning_feasible), std::ref(depth), std::ref(save_error_code), std::set<unsigned>()));
       depth=4;
       return;
    };
@@ -588,7 +717,7 @@ Element UserInterface::perf_summary_window(bool focused) {
    header.push_back(text("Bitmasks"));
    header.push_back(text("Size"));
    header.push_back(text("Avg LLC"));
-   header.push_back(text("Avg Misses"));
+   header.push_back(text("Avg Misses/Obj"));
    header.push_back(text("Status"));
    header.push_back(text("Junk/Root"));
    for (auto& text : header) {
@@ -626,14 +755,17 @@ Element UserInterface::perf_summary_window(bool focused) {
       if (!cos.misses.empty()) {
          misses_average = std::accumulate(cos.misses.begin(), cos.misses.end(), static_cast<uint64_t>(0)) / cos.misses.size();
       } else { misses_average = 0;}
+      // status follows the cos' objective, plain misses unless configured otherwise
+      bool custom_objective = pqos.has_custom_objective(cos.id);
+      uint64_t objective_average = custom_objective ? static_cast<uint64_t>(pqos.get_cos_objective(cos.id, cos.misses.size(), scaled_threshold)) : misses_average;
 
       Elements option_texts;
       option_texts.push_back(text(std::to_string(cos.id)));
       option_texts.push_back(text(Misc::to_range_extraction(cos.cores)));
-      option_texts.push_back(text(cos.bitmask));
+      option_texts.push_back(text(cos.bitmask.to_binary()));
       option_texts.push_back(text(Misc::format_bytes(cos.size)));
       option_texts.push_back(text(Misc::format_bytes(llc_average)));
-      option_texts.push_back(text(Misc::format_misses(misses_average)));
+      option_texts.push_back(text(Misc::format_misses(misses_average) + (custom_objective ? " / " + Misc::format_misses(objective_average) : "")));
       if (cos.cores.empty()) {
          option_texts.push_back(text("N/A")); // status
          option_texts.push_back(text("")); // Junk/root
@@ -641,10 +773,10 @@ Element UserInterface::perf_summary_window(bool focused) {
          if (cos.id == 0) {
             option_texts.push_back(text("Cores Error") | color(Color::Red));
          }
-         else if (llc_average/cos.size >= 1.0 || misses_average >= scaled_threshold) {
+         else if (llc_average/cos.size >= 1.0 || objective_average >= scaled_threshold) {
             option_texts.push_back(text("High") | color(Color::Red));
          }
-         else if (llc_average/cos.size >= 0.85 || misses_average >= std::max(0, scaled_threshold-1000)) {
+         else if (llc_average/cos.size >= 0.85 || objective_average >= std::max(0, scaled_threshold-1000)) {
             option_texts.push_back(text("Limit") | color(Color::Yellow));
          }
          else {
@@ -793,10 +925,18 @@ Element UserInterface::analysis_report() {
       Elements cos_result;
       std::map<unsigned, int> min_ways_map = pqos.get_autotuna_min_ways_map(); 
       std::map<unsigned, std::vector<uint64_t>> misses_matrix = pqos.get_cos_misses_matrix();
+      std::map<unsigned, std::vector<uint64_t>> objective_matrix = pqos.get_cos_objective_matrix();
+      std::map<unsigned, double> estimated_curves = pqos.get_estimated_curves();
       for (const auto&[cos, min_ways]: min_ways_map) {
          std::string cos_str = "Cos " + std::to_string(cos);
          std::string ways_str = std::to_string(min_ways) + " ways";
          std::string misses_str = (cos == root_cos) ? "Junk/Root" : Misc::format_misses(misses_matrix[cos][min_ways-1]);
+         if (cos != root_cos && pqos.has_custom_objective(cos)) {
+            misses_str += " (objective " + Misc::format_misses(objective_matrix[cos][min_ways-1]) + ")";
+         }
+         if (estimated_curves.find(cos) != estimated_curves.end()) {
+            misses_str += " (estimated, " + std::to_string(static_cast<int>(estimated_curves[cos] * 100)) + "% conf.)";
+         }
          cos_result.push_back(text(cos_str));
          cos_result.push_back(text(ways_str));
          cos_result.push_back(text(misses_str));
@@ -831,6 +971,194 @@ Element UserInterface::analysis_report() {
               }) | border; 
 }
 
+Element UserInterface::autotuning_plans_report() {
+   std::vector<Autotuna::tuning_plan> plans = pqos.get_autotuna_plans();
+   if (plans.empty()) return text(" No feasible allocation, keeping minimum needed ways") | color(Color::Yellow);
+
+   Elements rows;
+   for (size_t i=0; i<plans.size(); ++i) {
+      std::string title = i == 0 ? " Proposed" : " Runner-up " + std::to_string(i);
+      std::string ways_str;
+      for (const auto&[cos, ways] : plans[i].ways_map) {
+         ways_str += " Cos " + std::to_string(cos) + ": " + std::to_string(ways) + (cos == root_cos ? " (Junk/Root)" : "") + " ";
+      }
+      for (const auto& overlap : plans[i].overlaps) {
+         ways_str += " [Cos " + std::to_string(overlap.head) + " & Cos " + std::to_string(overlap.tail) + " share " + std::to_string(overlap.num_shared) + "]";
+      }
+      std::string cost_str = " predicted cost " + Misc::format_misses(static_cast<uint64_t>(plans[i].cost));
+      if (i > 0 && plans[0].cost > 0) {
+         std::ostringstream oss;
+         oss << std::fixed << std::setprecision(1) << (plans[i].cost / plans[0].cost - 1.0) * 100 << "%";
+         cost_str += " (+" + oss.str() + ")";
+      }
+      Element row = vbox({
+            text(title) | bold,
+            text(ways_str),
+            text(cost_str),
+            });
+      if (i > 0) row |= color(Color::GrayLight);
+      rows.push_back(row);
+   }
+   return vbox({std::move(rows)});
+}
+
+// What-if comparison of a candidate set of bitmasks against the live config, both predicted from the analysed miss curves
+Element UserInterface::prediction_panel(const std::map<unsigned, Way_Mask>& candidate) {
+   if (pqos.get_cos_misses_matrix().empty()) return text(" Run an AutoTuna analysis to predict the impact of changes") | color(Color::GrayLight);
+
+   int scaled_threshold = threshold * 1000;
+   std::map<unsigned, Way_Mask> live_bitmasks = pqos.get_live_bitmasks();
+   Autotuna::configuration_prediction live = pqos.predict_configuration(live_bitmasks, scaled_threshold);
+   Autotuna::configuration_prediction predicted = pqos.predict_configuration(candidate, scaled_threshold);
+
+   auto cell = [](const std::string& str) { return text(str) | size(WIDTH, EQUAL, 14); };
+   Elements rows;
+   rows.push_back(hbox({cell(" Cos"), cell("Ways"), cell("Misses now"), cell("Predicted"), cell("Occupancy")}) | bold);
+   for (const Autotuna::cos_prediction& cos_pred : predicted.cos_predictions) {
+      auto now = std::find_if(live.cos_predictions.begin(), live.cos_predictions.end(), [&](const auto& p) { return p.cos == cos_pred.cos; });
+      std::string live_ways = now == live.cos_predictions.end() ? "-" : std::to_string(now->num_ways);
+      std::string ways_str = live_ways + " -> " + std::to_string(cos_pred.num_ways);
+      std::string misses_now = now == live.cos_predictions.end() || !now->has_curve ? "-" : Misc::format_misses(static_cast<uint64_t>(now->misses));
+      std::string misses_predicted = cos_pred.has_curve ? Misc::format_misses(static_cast<uint64_t>(cos_pred.misses)) : "no curve";
+      Element row = hbox({cell(" Cos " + std::to_string(cos_pred.cos)), cell(ways_str), cell(misses_now), cell(misses_predicted), cell(Misc::format_bytes(cos_pred.occupancy))});
+      if (cos_pred.has_curve && cos_pred.misses >= scaled_threshold) row |= color(Color::Red);
+      else if (!cos_pred.has_curve) row |= color(Color::GrayLight);
+      rows.push_back(row);
+   }
+
+   std::string cost_str = " Weighted cost " + Misc::format_misses(static_cast<uint64_t>(live.cost)) + " -> " + Misc::format_misses(static_cast<uint64_t>(predicted.cost));
+   rows.push_back(text(cost_str));
+
+   std::vector<std::string> warnings = predicted.warnings;
+   std::vector<std::string> regressions = Autotuna::compare_predictions(live, predicted, scaled_threshold, pqos.get_setting("AUTOTUNA_PREDICTION_MAX_COST_INCREASE", 0.1));
+   warnings.insert(warnings.end(), regressions.begin(), regressions.end());
+   for (const std::string& warning : warnings) rows.push_back(text(" Warning: " + warning) | color(Color::Yellow));
+
+   return vbox({
+         text("Predicted impact") | hcenter,
+         vbox({std::move(rows)}),
+         });
+}
+
+// A/B experiment progress, then B - A per cos with confidence intervals
+Element UserInterface::experiment_report() {
+   std::string status = pqos.get_experiment_status();
+   if (status.empty()) return emptyElement();
+
+   Elements rows;
+   rows.push_back(text(" A/B experiment: " + status));
+   if (!pqos.is_experiment_active()) {
+      auto percent = [](double value) {
+         std::ostringstream oss;
+         oss << std::showpos << std::fixed << std::setprecision(1) << value * 100 << "%";
+         return oss.str();
+      };
+      for (const Autotuna::experiment_row& row : pqos.get_experiment_report()) {
+         if (row.metric != "misses" && row.metric != "objective") continue;
+         const Autotuna::effect_estimate& effect = row.effect;
+         std::string row_str = " Cos " + std::to_string(row.cos) + " " + row.metric + ": A " + Misc::format_misses(static_cast<uint64_t>(effect.mean_a)) +
+                               ", B " + Misc::format_misses(static_cast<uint64_t>(effect.mean_b));
+         if (effect.mean_a > 0) {
+            row_str += ", B-A " + percent(effect.relative) + " [" + percent(effect.ci_low / effect.mean_a) + ", " + percent(effect.ci_high / effect.mean_a) + "]";
+         }
+         Element row_text = text(row_str);
+         if (!effect.significant) row_text |= color(Color::GrayLight); // no detectable difference
+         else row_text |= color(effect.difference < 0 ? Color::Green : Color::Red);
+         rows.push_back(row_text);
+      }
+   }
+   return vbox({std::move(rows)});
+}
+
+// Who hurts whom: row victim, column suspect, plus the ranked suspects of the cos selected in the summary
+Element UserInterface::interference_window() {
+   Autotuna::interference_matrix matrix = pqos.get_interference_matrix();
+   if (matrix.size() < 2) return emptyElement();
+
+   auto score_text = [](double score) -> Element {
+      std::ostringstream oss;
+      oss << std::fixed << std::setprecision(2) << score;
+      Element element = text(oss.str()) | size(WIDTH, EQUAL, 8);
+      if (score >= 0.5) return element | color(Color::Red);
+      if (score >= 0.25) return element | color(Color::Yellow);
+      return element | color(Color::GrayLight);
+   };
+
+   Elements rows;
+   Elements header = {text("Victim") | size(WIDTH, EQUAL, 10)};
+   for (const auto&[cos, row] : matrix) header.push_back(text("Cos " + std::to_string(cos)) | size(WIDTH, EQUAL, 8));
+   rows.push_back(hbox({std::move(header)}) | bold);
+   for (const auto&[victim, row] : matrix) {
+      Elements cells = {text("Cos " + std::to_string(victim)) | size(WIDTH, EQUAL, 10)};
+      for (const auto&[suspect, suspect_row] : matrix) {
+         auto score = row.find(suspect);
+         cells.push_back(score == row.end() ? text("-") | size(WIDTH, EQUAL, 8) : score_text(score->second));
+      }
+      rows.push_back(hbox({std::move(cells)}));
+   }
+
+   std::vector<Autotuna::suspect> suspects = Autotuna::rank_suspects(matrix, autotuna_cos_selected);
+   if (!suspects.empty()) {
+      std::string suspects_str = " Cos " + std::to_string(autotuna_cos_selected) + " suspects:";
+      for (size_t i=0; i<suspects.size() && i<3; ++i) {
+         std::ostringstream oss;
+         oss << std::fixed << std::setprecision(2) << suspects[i].score;
+         suspects_str += " Cos " + std::to_string(suspects[i].cos) + " (" + oss.str() + ")";
+      }
+      rows.push_back(text(suspects_str));
+   }
+
+   return vbox({
+         text("Interference (who hurts whom)") | hcenter,
+         separator(),
+         vbox({std::move(rows)}),
+         });
+}
+
+// Latency of the hardware calls, process scans, config I/O and frame builds since start, and the startup stages
+Element UserInterface::diagnostics_window() {
+   auto cell = [](const std::string& str, int width) { return text(str) | size(WIDTH, EQUAL, width); };
+
+   Elements rows;
+   rows.push_back(hbox({cell("Call", 24), cell("Count", 10), cell("p50", 12), cell("p99", 12), cell("Max", 12)}) | bold);
+   for (int p=0; p<Latency::num_probes; ++p) {
+      Latency::summary summary = Latency::summarise(static_cast<Latency::probe>(p));
+      if (summary.count == 0) {
+         rows.push_back(hbox({cell(Latency::get_name(static_cast<Latency::probe>(p)), 24), cell("0", 10), cell("-", 12), cell("-", 12), cell("-", 12)}) | color(Color::GrayDark));
+         continue;
+      }
+      rows.push_back(hbox({
+            cell(Latency::get_name(static_cast<Latency::probe>(p)), 24),
+            cell(std::to_string(summary.count), 10),
+            cell(Misc::format_nanoseconds(summary.p50), 12),
+            cell(Misc::format_nanoseconds(summary.p99), 12),
+            cell(Misc::format_nanoseconds(summary.max), 12),
+            }));
+   }
+
+   Elements stages;
+   stages.push_back(hbox({cell("Stage", 24), cell("Start", 12), cell("Duration", 12), cell("", 10)}) | bold);
+   for (const stage_timing& timing : startup.get_timings()) {
+      auto ms = [](double value) {
+         std::ostringstream oss;
+         oss << std::fixed << std::setprecision(1) << value << " ms";
+         return oss.str();
+      };
+      Element status = timing.skipped ? text("skipped") | color(Color::Yellow) : timing.succeeded ? text("ok") | color(Color::Green) : text("failed") | color(Color::Red);
+      stages.push_back(hbox({cell(timing.name, 24), cell(ms(timing.start), 12), cell(ms(timing.duration), 12), status}));
+   }
+
+   return vbox({
+         text("Latency") | hcenter,
+         separator(),
+         vbox({std::move(rows)}),
+         separator(),
+         text("Startup") | hcenter,
+         separator(),
+         vbox({std::move(stages)}),
+         }) | border | flex;
+}
+
 bool UserInterface::KeyCallback(bool tag_focused, bool bitmask_focused, bool cores_focused, bool perf_summary_focused, bool priority_focused, ScreenInteractive& screen, Event& event) {
 
    /* Key Logging */
@@ -870,6 +1198,10 @@ bool UserInterface::KeyCallback(bool tag_focused, bool bitmask_focused, bool cor
          if (bitmask_focused) { 
             pqos.update_new_bitmask(bit_selected, cos_selected);
          }
+         else if (cores_focused && core_range_anchor >= 0) {
+            pqos.update_new_cores(Cpu_Set::range(core_range_anchor, core_selected), cos_selected);
+            core_range_anchor = -1;
+         }
          else if (cores_focused) {
             pqos.update_new_cores(core_selected, cos_selected);
          }
@@ -877,6 +1209,52 @@ bool UserInterface::KeyCallback(bool tag_focused, bool bitmask_focused, bool cor
       return false;
    }
 
+   /* v marks a range's first core, t/n/l toggle the selected core's SMT siblings, NUMA node or L3 domain - cores window */
+   if (cores_focused && cos_selected != 0 && event.is_character()) {
+      const Topology::cpu_topology& topology = Topology::get();
+      switch (event.character()[0]) {
+         case 'v':
+            core_range_anchor = core_range_anchor == core_selected ? -1 : core_selected;
+            return true;
+         case 't':
+            pqos.update_new_cores(Cpu_Set::smt_siblings(topology, core_selected), cos_selected);
+            return true;
+         case 'n':
+            pqos.update_new_cores(Cpu_Set::numa_node(topology, core_selected), cos_selected);
+            return true;
+         case 'l':
+            pqos.update_new_cores(Cpu_Set::l3_domain(topology, core_selected), cos_selected);
+            return true;
+      }
+   }
+
+   /* +/- zoom, </> pan and 0 reset the line plots' time range - AutoTuna tab */
+   if (tab_selected == 1 && depth == 0 && event.is_character()) {
+      const std::vector<size_t> spans = {0, 60, 300, 900, 3600, 6 * 3600, 24 * 3600}; // 0: one sample per column
+      size_t level = std::find(spans.begin(), spans.end(), line_plot_window.span) - spans.begin();
+      size_t pan_step = line_plot_window.span == 0 ? 10 : line_plot_window.span / 2;
+      // panning stops once the oldest sample is at the left edge
+      size_t history = pqos.get_history_length();
+      size_t max_offset = history > line_plot_visible ? history - line_plot_visible : 0;
+      switch (event.character()[0]) {
+         case '+':
+            if (level > 0) line_plot_window.span = spans[level - 1];
+            return true;
+         case '-':
+            if (level + 1 < spans.size()) line_plot_window.span = spans[level + 1];
+            return true;
+         case '<':
+            line_plot_window.offset = std::min(line_plot_window.offset + pan_step, max_offset);
+            return true;
+         case '>':
+            line_plot_window.offset -= std::min(line_plot_window.offset, pan_step);
+            return true;
+         case '0':
+            line_plot_window = {};
+            return true;
+      }
+   }
+
    /* S key handler - change depth to toggle Save Options Modal */
    if (tab_selected == 0 && !tag_focused && event.is_character() && event.character()[0] == 's') {
       switch (depth) {
@@ -921,42 +1299,43 @@ void UserInterface::start() {
 
    auto cachetuna_renderer = Renderer(cachetuna_components, [&] {
          return vbox({
-               cpu_cache_info_hbox(), // cpu and cache info
+               memoise("cpu_cache_info", {frame_dimx, startup.is_done("cpu_info")}, [&] { return cpu_cache_info_hbox(); }), // cpu and cache info
                separator(),
                vbox({ // CoS options
                      text("Policies") | hcenter | bold | color(Color::Blue),
+                     pqos.is_canary_active() ? text(pqos.get_canary_status()) | hcenter | color(Color::Yellow) : emptyElement(),
                      separator(),
                      l3cos_menu_options->Render(), // hidden
-                     l3cos_menu_options_boxes(tab_toggle->Focused()), // shown
+                     memoise("cos_boxes", {config_version, static_cast<uint64_t>(cos_selected), tab_toggle->Focused(), frame_dimx}, [&] { return l3cos_menu_options_boxes(tab_toggle->Focused()); }), // shown
                      }),
                separator(),
                hbox({ // CoS Info
                      vbox({
                            // stats
-                           cos_stats_box(),
+                           memoise("cos_stats", {data_version, static_cast<uint64_t>(cos_selected)}, [&] { return cos_stats_box(); }),
                            // settings
                               // tag
                            tag_selector->Render(),
-                           tag_window(tag_selector->Focused()),
+                           memoise("tag", {config_version, static_cast<uint64_t>(cos_selected), tag_selector->Focused()}, [&] { return tag_window(tag_selector->Focused()); }),
                               // bitmask
                            bitmask_selector->Render(),
-                           bitmask_window(bitmask_selector->Focused()),
+                           memoise("bitmask", {config_version, static_cast<uint64_t>(cos_selected), static_cast<uint64_t>(bit_selected), bitmask_selector->Focused()}, [&] { return bitmask_window(bitmask_selector->Focused()); }),
                               // cores
                            cores_selector->Render(),
-                           cores_window(cores_selector->Focused()),
+                           memoise("cores", {data_version, config_version, static_cast<uint64_t>(cos_selected), static_cast<uint64_t>(core_selected), static_cast<uint64_t>(core_range_anchor), cores_selector->Focused()}, [&] { return cores_window(cores_selector->Focused()); }),
                            })
                            | size(WIDTH, EQUAL, int(Terminal::Size().dimx * 0.15)),
                      hbox({
                            // Graphs 
                            hbox({
-                              llc_bar_graph.get_graph(pqos.get_l3_cos_vec()[cos_selected].llc) | xflex_grow,
+                              memoise("llc_bar", {data_version, static_cast<uint64_t>(cos_selected)}, [&] { return llc_bar_graph.get_graph(pqos.get_cos_llc_vec(cos_selected)); }) | xflex_grow,
                               separator(),
-                              misses_bar_graph.get_graph(pqos.get_l3_cos_vec()[cos_selected].misses) | xflex_grow,
+                              memoise("misses_bar", {data_version, static_cast<uint64_t>(cos_selected)}, [&] { return misses_bar_graph.get_graph(pqos.get_cos_misses_vec(cos_selected)); }) | xflex_grow,
                               }) | xflex_grow,
                            separator(),
                            // Process list
                            processes_selector->Render(),
-                           processes_list(processes_selector->Focused()),
+                           memoise("processes", {config_version, static_cast<uint64_t>(cos_selected), static_cast<uint64_t>(process_selected), processes_selector->Focused(), frame_dimx, frame_dimy}, [&] { return processes_list(processes_selector->Focused()); }),
                            })
                      | border 
                      | xflex_grow 
@@ -973,8 +1352,10 @@ void UserInterface::start() {
    Component threshold_slider = get_threshold_slider();
    Component priority_selector = get_priority_selector();
    Component analyse_button_selector = get_analyse_button_selector();
+   Component continuous_checkbox = Checkbox(" Continuous tuning", &pqos.continuous_tuning);
+   Component online_search_checkbox = Checkbox(" Online search", &pqos.online_search);
 
-   Component autotuning_button = Button("Auto-Tune", [&] {depth=5;}, ButtonOption::Border());
+   Component autotuning_button = Button("Auto-Tune", [&] {pqos.plan_autotuna_tuning(root_cos); depth=5;}, ButtonOption::Border());
    auto reset_autotuning = [&] {
          std::filesystem::remove(Misc::get_executable_path() + "autotuna_rollback.conf"); 
          tuning_feasible = false;
@@ -989,6 +1370,8 @@ void UserInterface::start() {
          perf_summary_selector,
          threshold_slider,
          analyse_button_selector,
+         continuous_checkbox,
+         online_search_checkbox,
          priority_selector,
          autotuning_button,
          Container::Horizontal({
@@ -1006,13 +1389,13 @@ void UserInterface::start() {
          return vbox({
                vbox({ // CoS performance summary
                      perf_summary_selector->Render(),
-                     perf_summary_window(perf_summary_selector->Focused()),
+                     memoise("perf_summary", {data_version, config_version, static_cast<uint64_t>(autotuna_cos_selected), perf_summary_selector->Focused(), static_cast<uint64_t>(root_cos), static_cast<uint64_t>(threshold), frame_dimx}, [&] { return perf_summary_window(perf_summary_selector->Focused()); }),
                      }),
                hbox({
                   vbox({ // Line plots
-                        llc_line_plot.get_graph(pqos.get_all_llc_vec(), pqos.get_mon_data_index_vec()),
+                        line_plot(llc_line_plot, "llc_plot", false),
                         separatorEmpty(),
-                        misses_line_plot.get_graph(pqos.get_all_misses_vec(), pqos.get_mon_data_index_vec())
+                        line_plot(misses_line_plot, "misses_plot", true)
                         }) | size(WIDTH, EQUAL, Terminal::Size().dimx * 0.5),
                   separator(),
                   vbox({
@@ -1023,7 +1406,21 @@ void UserInterface::start() {
                              separatorEmpty(),
                              analyse_button_selector->Render(), analyse_button_texts(analyse_button_selector->Focused()),
                         }),
-                        pqos.analysis_completed ? analysis_report() : emptyElement(),
+                        hbox({
+                             continuous_checkbox->Render(),
+                             separatorEmpty(),
+                             pqos.continuous_tuning ? text(pqos.get_continuous_status()) | color(Color::GrayLight) : emptyElement(),
+                        }),
+                        hbox({
+                             online_search_checkbox->Render(),
+                             separatorEmpty(),
+                             pqos.online_search ? text(pqos.get_online_search_status()) | color(Color::GrayLight) : emptyElement(),
+                        }),
+                        pqos.get_forecast_summary().empty() ? emptyElement() : text(" " + pqos.get_forecast_summary()) | color(Color::GrayLight),
+                        pqos.get_phase_status().empty() ? emptyElement() : text(" " + pqos.get_phase_status()) | color(Color::Yellow),
+                        memoise("experiment", {data_version}, [&] { return experiment_report(); }),
+                        memoise("interference", {data_version, static_cast<uint64_t>(autotuna_cos_selected)}, [&] { return interference_window(); }),
+                        pqos.analysis_completed ? memoise("analysis", {data_version, config_version}, [&] { return analysis_report(); }) : emptyElement(),
                         pqos.analysis_completed && tuning_feasible && !pqos.autotuning_completed ? 
                              priority_selector->Render(), priority_window(priority_selector->Focused()) : emptyElement(),
                         hbox({
@@ -1036,10 +1433,13 @@ void UserInterface::start() {
             });
          });
 
-   // Tab container - CacheTuna & AutoTuna
+   auto diagnostics_renderer = Renderer([&] { return diagnostics_window(); });
+
+   // Tab container - CacheTuna, AutoTuna & Diagnostics
    auto tab_container = Container::Tab({
          cachetuna_renderer,
          autotuna_renderer,
+         diagnostics_renderer,
          },
          &tab_selected);
 
@@ -1052,7 +1452,11 @@ void UserInterface::start() {
    // Render all primary components
    auto primary_renderer = Renderer(primary_container, [&] {
          return vbox({
-               tab_toggle->Render(), // Tab toggle
+               hbox({
+                     tab_toggle->Render(), // Tab toggle
+                     filler(),
+                     show_frame_time ? text(get_frame_time_summary() + " ") | color(Color::GrayDark) : emptyElement(),
+                     }),
                separator(),
                tab_container->Render(), // CacheTuna tab
                })
@@ -1066,6 +1470,8 @@ void UserInterface::start() {
          return vbox({
                text( " Save Options") | hcenter,
                separator(),
+               prediction_panel(pqos.get_new_bitmasks()),
+               separator(),
                filler(),
                vbox({
                      save_options_menu->Render(),
@@ -1114,6 +1520,14 @@ void UserInterface::start() {
             case 9:
                error_msg = " File not found";
                break;
+            // 10: cachetuna - canary apply
+            case 10:
+               error_msg = " " + pqos.get_canary_status() + ", previous config restored";
+               break;
+            // 11: cachetuna - trials (A/B experiment, canary)
+            case 11:
+               error_msg = " Cannot start: a trial is already running, changes are unsaved, or an experiment config moves cores";
+               break;
          }
          return vbox({
                text(error_msg),
@@ -1145,14 +1559,14 @@ void UserInterface::start() {
                | center;
    });
 
-   // Loading animation
-   std::string img_path = Misc::get_executable_path() + "img/Tuna/";
-   std::vector<std::vector<std::string>> tuna_frames = Braille_Generator::generate_all_frames(int(Terminal::Size().dimx*0.5), int(Terminal::Size().dimy*0.7), img_path, 10);
+   // Loading animation, frames of the current size are generated in the background (or read from the disk cache)
+   Braille_Generator::Frame_Cache tuna_frames(Misc::get_executable_path() + "img/Tuna/", 10);
+   tuna_frames.prepare(int(Terminal::Size().dimx*0.5), int(Terminal::Size().dimy*0.7));
 
    auto analyse_loading_modal = Renderer([&] {
          auto get_frame = [&] (int index) -> Element{
               Elements lines;
-              for (const auto& it : tuna_frames[index % tuna_frames.size()]) {
+              for (const auto& it : tuna_frames.get_frame(int(frame_dimx*0.5), int(frame_dimy*0.7), index)) {
                   lines.push_back(text(it));
               }
               return vbox({std::move(lines)});
@@ -1174,6 +1588,10 @@ void UserInterface::start() {
          return vbox({
                text( " Are you sure you want to proceed auto-tuning?") | hcenter,
                separator(),
+               autotuning_plans_report(),
+               separator(),
+               prediction_panel(pqos.get_plan_bitmasks(0)),
+               separator(),
                filler(),
                vbox({
                      autotuning_options_menu->Render(),
@@ -1195,6 +1613,13 @@ void UserInterface::start() {
          &depth);
 
    auto main_renderer = Renderer(main_container, [&] {
+         auto frame_start = std::chrono::steady_clock::now();
+         Tracer::Span span("frame");
+         refresh_pending = false;
+         data_version = pqos.get_data_version();
+         config_version = pqos.get_config_version();
+         frame_dimx = Terminal::Size().dimx;
+         frame_dimy = Terminal::Size().dimy;
          Element document = primary_renderer->Render();
          switch (depth) {
             case 1: // save options menu
@@ -1228,12 +1653,19 @@ void UserInterface::start() {
                      });
                break;
          }
+         record_frame_time(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
          return document;
          });
 
    ScreenInteractive screen = ScreenInteractive::Fullscreen();
    // key handler
    Component main_component = CatchEvent(main_renderer, [&](Event event) {
+         // targeted re-analysis after a phase change, once no modal is open
+         if (event == Event::Custom && phase_reanalysis && depth == 0) {
+            threads.push_back(std::thread(&Pqos::process_autotuna_analysis, std::ref(pqos), threshold, root_cos, std::ref(tuning_feasible), std::ref(depth), std::ref(save_error_code), phase_targets));
+            depth = 4;
+            phase_reanalysis = false;
+         }
          return KeyCallback(tag_selector->Focused(), bitmask_selector->Focused(), cores_selector->Focused(), perf_summary_selector->Focused(), priority_selector->Focused(), screen, event);
          });
 
@@ -1241,6 +1673,7 @@ void UserInterface::start() {
    threads.push_back(std::thread(&UserInterface::poll_data, this, std::ref(screen)));
 
    // main loop
+   Tracer::set_thread_name("ui");
    screen.Loop(main_component);
    std::filesystem::remove(Misc::get_executable_path() + "unexpected_exit.conf"); 
    // signal threads to stop
@@ -1249,6 +1682,12 @@ void UserInterface::start() {
    for (auto& thread : threads) {
       thread.join();
    }
+   startup.wait_all();
+   // a running online search leaves its best allocation, not the trial, on the hardware
+   pqos.online_search = false;
+   pqos.step_online_search(threshold * 1000, root_cos);
+   pqos.persist_layout(); // continuous tuning may have moved ways since the last settled layout
    pqos.close();
+   Tracer::stop();
 
 }
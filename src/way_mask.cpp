@@ -0,0 +1,27 @@
+#include "way_mask.hpp"
+
+// '0'/'1' string, leftmost character first; other characters count as '0'
+Way_Mask Way_Mask::from_binary(const std::string& binary) {
+   Way_Mask mask(0, static_cast<unsigned>(binary.size()));
+   for (unsigned pos=0; pos<mask.num_ways; ++pos) mask.set(pos, binary[pos] == '1');
+   return mask;
+}
+
+std::string Way_Mask::to_binary() const {
+   std::string binary(num_ways, '0');
+   for (unsigned pos=0; pos<num_ways; ++pos) {
+      if (test(pos)) binary[pos] = '1';
+   }
+   return binary;
+}
+
+std::string Way_Mask::to_hex() const {
+   static const char digits[] = "0123456789abcdef";
+   std::string hex;
+   uint64_t rest = bits;
+   do {
+      hex.insert(hex.begin(), digits[rest & 0xf]);
+      rest >>= 4;
+   } while (rest != 0);
+   return "0x" + hex;
+}
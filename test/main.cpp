@@ -0,0 +1,216 @@
+// std
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// cachetuna
+#include "series_index.hpp"
+#include "way_mask.hpp"
+
+// autotuna
+#include "autotuna.hpp"
+#include "optimizer.hpp"
+
+/* Unit tests of the pieces the rest of AutoTuna relies on being exact: the optimizer against brute force,
+ * the way mask rules CAT and DDIO impose, and the min/max index against a linear scan.
+ * Exits with 1 if any check failed, so ctest reports it.
+*/
+
+static int num_checks = 0;
+static int num_failed = 0;
+
+static void check(bool condition, const std::string& what) {
+   ++num_checks;
+   if (condition) return;
+   ++num_failed;
+   std::cerr << "FAILED: " << what << std::endl;
+}
+
+// Costs of every allocation within the limits that fits into the ways, cheapest first
+static std::vector<double> brute_force(const Autotuna::optimizer_problem& problem) {
+   std::vector<double> costs;
+   std::vector<int> ways(problem.num_cos);
+   std::function<void(int, int, double)> enumerate = [&](int i, int used, double cost) {
+      if (i == problem.num_cos) {
+         costs.push_back(cost);
+         return;
+      }
+      for (int w=problem.min_ways[i]; w<=problem.max_ways[i] && used + w<=problem.num_ways; ++w) {
+         enumerate(i + 1, used + w, cost + problem.cost[i * problem.num_ways + w - 1]);
+      }
+   };
+   enumerate(0, 0, 0.0);
+   std::sort(costs.begin(), costs.end());
+   return costs;
+}
+
+static Autotuna::optimizer_problem random_problem(std::mt19937_64& random, bool convex) {
+   std::uniform_int_distribution<int> cos_count(1, 4), way_count(2, 8);
+   std::uniform_real_distribution<double> scale(1e3, 1e6), decay(0.2, 1.5), noise(0.5, 1.5);
+   Autotuna::optimizer_problem problem;
+   problem.num_cos = cos_count(random);
+   problem.num_ways = way_count(random);
+   for (int i=0; i<problem.num_cos; ++i) {
+      double base = scale(random), rate = decay(random);
+      for (int w=1; w<=problem.num_ways; ++w) {
+         double misses = base * std::exp(-rate * w);
+         problem.cost.push_back(std::round(convex ? misses : misses * noise(random)));
+      }
+      int min_ways = std::uniform_int_distribution<int>(1, 2)(random);
+      problem.min_ways.push_back(min_ways);
+      problem.max_ways.push_back(std::uniform_int_distribution<int>(min_ways, problem.num_ways)(random));
+   }
+   return problem;
+}
+
+static std::string describe(const Autotuna::optimizer_problem& problem) {
+   std::ostringstream text;
+   text << problem.num_cos << " cos x " << problem.num_ways << " ways, limits";
+   for (int i=0; i<problem.num_cos; ++i) text << " [" << problem.min_ways[i] << ", " << problem.max_ways[i] << "]";
+   return text.str();
+}
+
+static void test_optimizer() {
+   const int num_solutions = 4;
+   Autotuna::Optimizer optimizer;
+   std::mt19937_64 random(7);
+   for (bool convex : {true, false}) {
+      for (int run=0; run<500; ++run) {
+         Autotuna::optimizer_problem problem = random_problem(random, convex);
+         std::vector<double> expected = brute_force(problem);
+         std::vector<Autotuna::allocation> solutions = optimizer.solve(problem, num_solutions);
+         std::string name = std::string(convex ? "convex " : "non-convex ") + describe(problem);
+
+         check(solutions.size() == std::min(expected.size(), static_cast<size_t>(num_solutions)), "optimizer solution count, " + name);
+         for (size_t k=0; k<solutions.size() && k<expected.size(); ++k) {
+            const Autotuna::allocation& solution = solutions[k];
+            double cost = 0;
+            int used = 0;
+            bool within_limits = static_cast<int>(solution.ways.size()) == problem.num_cos;
+            for (int i=0; within_limits && i<problem.num_cos; ++i) {
+               within_limits = solution.ways[i] >= problem.min_ways[i] && solution.ways[i] <= problem.max_ways[i];
+               if (within_limits) cost += problem.cost[i * problem.num_ways + solution.ways[i] - 1];
+               used += solution.ways[i];
+            }
+            check(within_limits && used <= problem.num_ways, "optimizer allocation " + std::to_string(k) + " within limits, " + name);
+            check(std::abs(cost - solution.cost) < 1e-6, "optimizer allocation " + std::to_string(k) + " reports its cost, " + name);
+            check(std::abs(solution.cost - expected[k]) < 1e-6, "optimizer allocation " + std::to_string(k) + " matches brute force, " + name);
+         }
+      }
+   }
+
+   // min_ways that don't fit leave nothing to choose from
+   Autotuna::optimizer_problem crowded = {2, 3, {3, 2, 1, 3, 2, 1}, {2, 2}, {3, 3}};
+   check(optimizer.solve(crowded, 1).empty(), "optimizer returns no allocation when min_ways don't fit");
+}
+
+static void test_way_mask() {
+   Way_Mask mask = Way_Mask::range(11, 2, 3);
+   check(mask.to_binary() == "00111000000", "range counts positions from the left");
+   check(mask.first() == 2 && mask.last() == 4 && mask.count() == 3, "first, last and count of a range");
+   check(Way_Mask::from_binary("00111000000") == mask, "from_binary reads what to_binary writes");
+   check(mask.is_contiguous() && Way_Mask(0, 11).is_contiguous(), "a range and the empty mask are contiguous");
+   check(!Way_Mask::from_binary("01101000000").is_contiguous(), "a mask with a gap is not contiguous");
+   check(Way_Mask(0, 11).first() == Way_Mask::npos && Way_Mask::range(11, 0, 11).first_clear() == Way_Mask::npos, "npos without a set or clear way");
+
+   // DDIO: positions 0 and 1 are written together, a mask never holds just one of them
+   const int num_ways = 11;
+   for (std::pair<int, int> contention : {std::make_pair(-1, -1), std::make_pair(0, 1), std::make_pair(2, 4)}) {
+      for (int width=1; width<=num_ways; ++width) {
+         for (int pos_0=0; pos_0 + width<=num_ways; ++pos_0) {
+            if (pos_0 == 1) continue; // layout_bitmasks never starts a group between the DDIO ways
+            Way_Mask constructed = Autotuna::construct_way_mask(contention, num_ways, width, pos_0);
+            std::string name = "construct_way_mask(" + std::to_string(width) + " ways at " + std::to_string(pos_0) + ", contention " + std::to_string(contention.first) + "-" + std::to_string(contention.second) + ")";
+            check(static_cast<int>(constructed.count()) == width && constructed.is_contiguous(), name + " is a contiguous run of its ways");
+            if (contention.first == 0) check(constructed.test(0) == constructed.test(1), name + " keeps the DDIO ways together");
+            int last = static_cast<int>(constructed.last());
+            check(last < contention.first || last >= contention.second, name + " doesn't end inside the contention ways");
+         }
+      }
+   }
+
+   // one way moves keep the masks disjoint, contiguous and DDIO safe, and leave cos outside the move alone
+   std::mt19937_64 random(11);
+   for (int run=0; run<2000; ++run) {
+      std::map<unsigned, Way_Mask> bitmasks;
+      int pos = 0;
+      for (unsigned cos=1; cos<=4 && pos<num_ways; ++cos) {
+         if (pos > 0) pos += std::uniform_int_distribution<int>(0, 1)(random); // a free way now and then, never between the DDIO ways
+         int width = std::uniform_int_distribution<int>(pos == 0 ? 2 : 1, 3)(random);
+         if (pos + width > num_ways) break;
+         bitmasks[cos] = Way_Mask::range(num_ways, pos, width);
+         pos += width;
+      }
+      if (bitmasks.size() < 2) continue;
+      unsigned donor = std::uniform_int_distribution<unsigned>(1, bitmasks.size())(random);
+      unsigned receiver = std::uniform_int_distribution<unsigned>(1, bitmasks.size())(random);
+      std::map<unsigned, Way_Mask> moved = Autotuna::move_one_way(bitmasks, {0, 1}, donor, receiver);
+      if (moved.empty()) continue;
+
+      std::string name = "move_one_way " + std::to_string(donor) + " -> " + std::to_string(receiver) + " from";
+      for (const auto&[cos, bitmask] : bitmasks) name += " " + bitmask.to_binary();
+      Way_Mask used(0, num_ways);
+      bool valid = moved.size() == bitmasks.size();
+      unsigned lo = std::min(bitmasks[donor].first(), bitmasks[receiver].first());
+      unsigned hi = std::max(bitmasks[donor].last(), bitmasks[receiver].last());
+      for (const auto&[cos, bitmask] : moved) {
+         valid = valid && bitmask.is_contiguous() && !used.overlaps(bitmask) && bitmask.test(0) == bitmask.test(1);
+         used |= bitmask;
+         int expected = static_cast<int>(bitmasks[cos].count()) + (cos == receiver) - (cos == donor);
+         valid = valid && static_cast<int>(bitmask.count()) == expected;
+         // only the donor, the receiver and the cos between them may change
+         if (bitmasks[cos].last() < lo || bitmasks[cos].first() > hi) valid = valid && bitmask == bitmasks[cos];
+      }
+      check(valid, name);
+   }
+   check(Autotuna::move_one_way({{1, Way_Mask::range(num_ways, 0, 2)}, {2, Way_Mask::range(num_ways, 1, 2)}}, {0, 1}, 1, 2).empty(), "move_one_way refuses overlapping masks");
+   check(Autotuna::move_one_way({{1, Way_Mask::range(num_ways, 0, 2)}, {2, Way_Mask::range(num_ways, 2, 2)}}, {0, 1}, 1, 2).empty(), "move_one_way refuses to split the DDIO ways");
+}
+
+static void test_series_index() {
+   std::mt19937_64 random(3);
+   std::uniform_int_distribution<uint64_t> sample(0, 1000000);
+   const size_t capacity = 1000;
+   for (size_t block_size : {1, 7, 64}) {
+      Series_Index index(capacity, block_size);
+      std::vector<uint64_t> values;
+      // fill past the capacity so the ring of blocks wraps around
+      for (size_t step=0; step<3000; ++step) {
+         values.push_back(sample(random));
+         index.push(values.back());
+         if (values.size() > capacity) {
+            values.erase(values.begin());
+            index.pop_front();
+         }
+         if (step % 97 != 0) continue;
+         for (int query=0; query<20; ++query) {
+            size_t first = std::uniform_int_distribution<size_t>(0, values.size())(random);
+            size_t last = std::uniform_int_distribution<size_t>(first, values.size() + 5)(random);
+            series_span span = index.span(values, first, last);
+            size_t end = std::min(last, values.size());
+            std::string name = "span [" + std::to_string(first) + ", " + std::to_string(last) + ") of " + std::to_string(values.size()) + " samples, block size " + std::to_string(block_size);
+            if (first >= end) {
+               check(span.min == Series_Index::no_value && span.max == 0, name + " is empty");
+               continue;
+            }
+            check(span.min == *std::min_element(values.begin() + first, values.begin() + end), name + " min");
+            check(span.max == *std::max_element(values.begin() + first, values.begin() + end), name + " max");
+            check(span.last == values[end - 1], name + " last");
+         }
+      }
+   }
+}
+
+int main() {
+   test_optimizer();
+   test_way_mask();
+   test_series_index();
+   std::cout << num_checks - num_failed << "/" << num_checks << " checks passed" << std::endl;
+   return num_failed == 0 ? 0 : 1;
+}